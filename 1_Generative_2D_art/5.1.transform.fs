@@ -4,11 +4,16 @@ out vec4 FragColor;
 in vec3 ourColor;
 in vec2 TexCoord;
 
-uniform float iTime;
+// per-frame data, one buffer write per frame (must match FrameUniforms in transformations.cpp)
+layout (std140) uniform Frame
+{
+    vec2 uMousePos;
+    float iTime;
+    vec2 uViewport;
+};
 uniform sampler2D texture1; // Ѻ Texture ͧš
 uniform sampler2D texture2; // Ѻ Texture ͧШѹ
 uniform int useTexture; // 1 = Ҵš, 2 = ҴǧШѹ, 3 = Ҵǧ⤨
-uniform vec2 uMousePos;
 uniform vec2 uCenter;
 
 
@@ -0,0 +1,101 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 ourColor;
+in vec2 TexCoord;
+flat in int material;
+flat in float dashCount;                   // orbit rings: half the segments of buildDashedCircle(), per instance
+flat in vec2 center;
+
+// material IDs (MATERIAL_* in transformations.cpp)
+const int MATERIAL_SUN = 0;                // generative pattern
+const int MATERIAL_LINE = 1;               // vertex color (orbit lines)
+const int MATERIAL_TEXTURE = 2;            // + layer of uTextures, lit from the mouse
+
+uniform sampler2DArray uTextures;
+uniform bool uSdfShapes;                   // shapes are quads: unit disk / dashed unit ring computed from uv
+
+const float LINE_WIDTH = 1.0;              // orbit ring, in pixels (as GL_LINES)
+
+// per-frame data, one buffer write per frame (must match FrameUniforms in transformations.cpp)
+layout (std140) uniform Frame
+{
+    vec2 uMousePos;
+    float iTime;
+    vec2 uViewport;
+};
+
+
+vec3 palette( float t ) {
+    vec3 a = vec3(1.000, 0.500, 0.500);
+    vec3 b = vec3(0.500, 0.500, 0.500);
+    vec3 c = vec3(0.750, 1.000, 0.667);
+    vec3 d = vec3(0.800, 1.000, 0.333);
+
+    return a + b*cos( 6.28318*(c*t+d) );
+}
+
+// analytic coverage of the shape at uv (-1..1 across the quad), anti-aliased
+// over one pixel: the unit disk for bodies, a dashed ring on the unit circle
+// for the orbit lines
+float shapeCoverage(vec2 uv)
+{
+    float r = length(uv);
+    float pixel = max(fwidth(r), 1e-6);    // uv units per pixel
+    if (material != MATERIAL_LINE)
+        return clamp((1.0 - r) / pixel + 0.5, 0.0, 1.0);
+
+    float ring = clamp(0.5 * LINE_WIDTH - abs(r - 1.0) / pixel + 0.5, 0.0, 1.0);
+    // dash coordinate along the ring, and how much of it one pixel covers (no
+    // fwidth() here: atan() jumps at -pi)
+    float t = atan(uv.y, uv.x) / 6.28318 * dashCount;
+    float dashPixel = dashCount / 6.28318 * pixel / max(r, 1e-4);
+    float fromCenter = abs(fract(t + 0.25) - 0.5);         // dash k covers [k, k + 0.5]
+    float dash = clamp((0.25 - fromCenter) / dashPixel + 0.5, 0.0, 1.0);
+    return ring * dash;
+}
+
+void main()
+{
+    vec2 uv = TexCoord * 2.0 - 1.0;
+    vec2 uv0 = uv;
+    float coverage = uSdfShapes ? shapeCoverage(uv) : 1.0;     // before any discard, fwidth() needs the neighbours
+    if (material == MATERIAL_LINE)
+    {
+        FragColor = vec4(ourColor, 1.0);
+    }
+    else if (material >= MATERIAL_TEXTURE)
+    {
+        vec4 texColor = texture(uTextures, vec3(TexCoord, float(material - MATERIAL_TEXTURE)));
+        if(texColor.a < 0.1) discard;
+
+        float ambientStrength = 0.5;
+        vec2 pixelPos = gl_FragCoord.xy;
+        vec2 lightDir = normalize(uMousePos - pixelPos);
+        vec2 normal = normalize(pixelPos - center);
+        float diff = max(dot(normal, lightDir), 0.0);
+        diff = smoothstep(0.0, 0.2, diff);
+
+        vec3 finalColor = texColor.rgb * (ambientStrength + diff);
+
+        FragColor = vec4(finalColor, texColor.a);
+    }
+    else
+    {
+        vec3 finalColor = vec3(0.0);
+        for (float i = 0; i < 4; i++){
+            uv = fract(uv * 1.5)-0.5;
+            float d = length(uv)*exp(-length(uv0));
+            vec3 col = palette(length(uv0) + i*0.2 + iTime*0.1);
+            d = sin(d*8.0+iTime)/8.0;
+            d = abs(d);
+            d = pow(0.01/d, 1.2);
+            finalColor += col * d;
+        }
+
+        FragColor = vec4(finalColor, 1.0);
+    }
+
+    if (coverage <= 0.0) discard;
+    FragColor.a *= coverage;
+}
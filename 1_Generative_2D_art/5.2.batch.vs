@@ -0,0 +1,45 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;        // shape vertex (shared VBO)
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in mat4 aTransform;  // per instance, locations 3-6
+layout (location = 7) in int aMaterial;    // per instance, see 5.2.batch.fs
+layout (location = 8) in float aShapeParam; // per instance: dashes of an orbit ring
+
+// per-frame data, one buffer write per frame (must match FrameUniforms in transformations.cpp)
+layout (std140) uniform Frame
+{
+    vec2 uMousePos;
+    float iTime;
+    vec2 uViewport;
+};
+
+uniform bool uSdfShapes;                   // shapes are quads, see 5.2.batch.fs
+
+const float SDF_MARGIN = 1.5;              // pixels around the unit circle: the AA edge and half the orbit line
+
+out vec3 ourColor;
+out vec2 TexCoord;
+flat out int material;
+flat out float dashCount;
+flat out vec2 center;                      // object center in window pixels, for the lighting
+
+void main()
+{
+    vec3 pos = aPos;
+    vec2 uv = aTexCoord;
+    if (uSdfShapes)
+    {
+        // grow the quad by SDF_MARGIN pixels on each axis (per axis: the earth's spin squashes x)
+        vec2 pixelsPerUnit = vec2(length(aTransform[0].xy * 0.5 * uViewport), length(aTransform[1].xy * 0.5 * uViewport));
+        vec2 grow = sign(aPos.xy) * SDF_MARGIN / max(pixelsPerUnit, vec2(1e-4));
+        pos.xy += grow;
+        uv += grow * 0.5;
+    }
+    gl_Position = aTransform * vec4(pos, 1.0);
+    ourColor = aColor;
+    TexCoord = uv;
+    material = aMaterial;
+    dashCount = aShapeParam;
+    center = (aTransform[3].xy * 0.5 + 0.5) * uViewport;
+}
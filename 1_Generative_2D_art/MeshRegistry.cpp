@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshRegistry.cpp
+// ================
+// Reference-counted unit meshes shared by (shape, segmentCount), packed in
+// one VBO + EBO.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <glad/glad.h>
+#include <cstddef>
+#include "MeshRegistry.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the mesh of (build, segmentCount), built and uploaded on the first request
+///////////////////////////////////////////////////////////////////////////////
+Mesh MeshRegistry::acquire(MeshBuilder build, int segmentCount)
+{
+    Key key(build, segmentCount);
+    std::map<Key, Entry>::iterator it = entries.find(key);
+    if (it == entries.end())
+    {
+        std::vector<float> meshVertices;
+        std::vector<unsigned int> meshIndices;
+        build(segmentCount, 1.0f, meshVertices, meshIndices);
+
+        Entry entry;
+        entry.mesh = append(meshVertices, meshIndices);
+        entry.refCount = 0;
+        it = entries.insert(std::make_pair(key, entry)).first;
+    }
+    ++it->second.refCount;
+    return it->second.mesh;
+}
+
+// a handful of meshes: found by their index range (ranges are never reused
+// while the buffers live)
+void MeshRegistry::release(const Mesh& mesh)
+{
+    for (std::map<Key, Entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->second.mesh.vao != mesh.vao || it->second.mesh.firstIndex != mesh.firstIndex)
+            continue;
+
+        if (--it->second.refCount == 0)
+        {
+            entries.erase(it);
+            if (entries.empty())
+                destroy();
+        }
+        return;
+    }
+}
+
+void MeshRegistry::releaseAll()
+{
+    entries.clear();
+    destroy();
+}
+
+int MeshRegistry::getRefCount(const Mesh& mesh) const
+{
+    for (std::map<Key, Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->second.mesh.vao == mesh.vao && it->second.mesh.firstIndex == mesh.firstIndex)
+            return it->second.refCount;
+    }
+    return 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// append a mesh of 8-float vertices to the shared VBO/EBO; the VAO and the
+// buffer names are created with the first mesh and kept, so VAOs of other
+// users (ShapeBatch) stay valid when the buffers are re-uploaded
+///////////////////////////////////////////////////////////////////////////////
+Mesh MeshRegistry::append(const std::vector<float>& meshVertices, const std::vector<unsigned int>& meshIndices)
+{
+    if (!vao)
+    {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        GLsizei stride = 8 * sizeof(float);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glBindVertexArray(0);
+    }
+
+    Mesh mesh = { vao, vbo, ebo, (int)meshIndices.size(), (int)indices.size(), (int)(vertices.size() / 8) };
+    vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+    indices.insert(indices.end(), meshIndices.begin(), meshIndices.end());
+
+    // the EBO through the copy-write target, not to change the bound VAO
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return mesh;
+}
+
+void MeshRegistry::destroy()
+{
+    if (vao)
+    {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+    }
+    vao = vbo = ebo = 0;
+    std::vector<float>().swap(vertices);
+    std::vector<unsigned int>().swap(indices);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// per-object draw of one mesh
+///////////////////////////////////////////////////////////////////////////////
+void drawMesh(const Mesh& mesh, unsigned int mode)
+{
+    glBindVertexArray(mesh.vao);
+    glDrawElementsBaseVertex(mode, mesh.indexCount, GL_UNSIGNED_INT,
+                             (void*)((std::size_t)mesh.firstIndex * sizeof(unsigned int)), mesh.baseVertex);
+}
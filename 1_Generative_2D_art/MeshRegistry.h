@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshRegistry.h
+// ==============
+// Shared GPU meshes of the 2D shapes, keyed by (shape, segmentCount). The
+// shape is the function that builds its geometry (buildCircle(),
+// buildDashedCircle() in transformations.cpp); every mesh is built once at
+// radius 1 and the radius goes into the object's transform, so the sun, the
+// earth and the moon share one 64-segment circle, and ShapeBatch draws its
+// instances from the same meshes (addShape()). acquire() hands out the
+// same mesh for the same key and counts the references.
+//
+// All meshes live in one VBO + EBO behind one VAO: a Mesh is an index range
+// (firstIndex, indexCount) over vertices from baseVertex, drawn with
+// drawMesh() or glDraw*BaseVertex, so switching shapes never rebinds buffers.
+// A new mesh is appended (the buffers are re-uploaded from a CPU copy, the
+// names stay the same); a released range is left as a hole until the last
+// mesh goes, which deletes the buffers.
+//
+// Vertex layout (8 floats, as ShapeBatch):
+//      0 position (vec3), 1 color (vec3), 2 texcoord (vec2)
+//
+// Like the other GL classes, acquire(), release() and releaseAll() need the
+// context current, the destructor does not touch GL.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_REGISTRY_H
+#define MESH_REGISTRY_H
+
+#include <map>
+#include <utility>
+#include <vector>
+
+struct Mesh {
+    unsigned int vao, vbo, ebo;             // shared by every mesh of the registry
+    int indexCount;                         // GL_LINES: 2 per line, not triangles
+    int firstIndex;                         // in the shared EBO
+    int baseVertex;                         // added to the indices, in the shared VBO
+};
+
+// glDrawElementsBaseVertex of the mesh range (binds its VAO)
+void drawMesh(const Mesh& mesh, unsigned int mode);
+
+class MeshRegistry
+{
+public:
+    // geometry of a shape at the given radius, appended to empty vectors
+    typedef void (*MeshBuilder)(int segmentCount, float radius, std::vector<float>& vertices, std::vector<unsigned int>& indices);
+
+    // ctor/dtor
+    MeshRegistry() : vao(0), vbo(0), ebo(0) {}
+    ~MeshRegistry() {}
+    MeshRegistry(const MeshRegistry&) = delete;
+    MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+    Mesh acquire(MeshBuilder build, int segmentCount);     // unit-radius mesh, uploaded on first use
+    void release(const Mesh& mesh);         // drop one reference, the buffers go with the last
+    void releaseAll();                      // delete every mesh, whatever its count
+
+    int getMeshCount() const { return (int)entries.size(); }        // distinct meshes on the GPU
+    int getRefCount(const Mesh& mesh) const;
+
+private:
+    typedef std::pair<MeshBuilder, int> Key;
+    struct Entry
+    {
+        Mesh mesh;
+        int refCount;
+    };
+
+    Mesh append(const std::vector<float>& meshVertices, const std::vector<unsigned int>& meshIndices);
+    void destroy();
+
+    std::map<Key, Entry> entries;
+    std::vector<float> vertices;            // CPU copy of the shared VBO, holes included
+    std::vector<unsigned int> indices;      // and of the shared EBO
+    unsigned int vao, vbo, ebo;
+};
+
+#endif
@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+// OrbitSystem.cpp
+// ===============
+// Analytic orbits of a body hierarchy (SoA), solved in one batched pass.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <algorithm>
+#include "OrbitSystem.h"
+#include "../common/simd_sincos.h"
+
+
+
+// constants //////////////////////////////////////////////////////////////////
+namespace
+{
+    const double TWO_PI = 6.283185307179586;
+    const float MAX_ECCENTRICITY = 0.9f;
+    const int KEPLER_ITERATIONS = 5;        // Newton steps, < 1e-6 rad for e <= 0.9
+
+    // x wrapped to [-pi, pi)
+    inline float wrapAngle(double x)
+    {
+        return (float)(x - TWO_PI * floor(x / TWO_PI + 0.5));
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+OrbitSystem::OrbitSystem() : maxEccentricity(0.0f)
+{
+    setKernel(KERNEL_AUTO);
+}
+
+void OrbitSystem::reserve(std::size_t count)
+{
+    parents.reserve(count);
+    semiMajor.reserve(count);
+    semiMinor.reserve(count);
+    eccentricities.reserve(count);
+    speeds.reserve(count);
+    phases.reserve(count);
+    tilts.reserve(count);
+    spins.reserve(count);
+}
+
+void OrbitSystem::clear()
+{
+    parents.clear();
+    semiMajor.clear();
+    semiMinor.clear();
+    eccentricities.clear();
+    speeds.clear();
+    phases.clear();
+    tilts.clear();
+    spins.clear();
+    maxEccentricity = 0.0f;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// append a body; the parent must exist already (parent-before-child order)
+///////////////////////////////////////////////////////////////////////////////
+int OrbitSystem::addBody(const Orbit& orbit)
+{
+    int body = (int)parents.size();
+    if (orbit.parent < ROOT || orbit.parent >= body)
+        return -1;
+
+    float e = std::min(std::max(orbit.eccentricity, 0.0f), MAX_ECCENTRICITY);
+    parents.push_back(orbit.parent);
+    semiMajor.push_back(orbit.radius);
+    semiMinor.push_back(orbit.radius * sqrtf(1.0f - e * e));
+    eccentricities.push_back(e);
+    speeds.push_back(orbit.speed);
+    phases.push_back(orbit.phase);
+    tilts.push_back(orbit.tilt);
+    spins.push_back(orbit.spin);
+    maxEccentricity = std::max(maxEccentricity, e);
+    return body;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// 1. wrap the mean anomalies and spin angles (double, so t may grow)
+// 2. batched Kepler solve -> offsets from the parents
+// 3. positions, parent before child
+///////////////////////////////////////////////////////////////////////////////
+void OrbitSystem::evaluate(double time)
+{
+    std::size_t count = parents.size();
+    anomalies.resize(count);
+    offsetX.resize(count);
+    offsetY.resize(count);
+    positionX.resize(count);
+    positionY.resize(count);
+    spinAngles.resize(count);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        anomalies[i] = wrapAngle((double)phases[i] + (double)speeds[i] * time);
+        spinAngles[i] = wrapAngle((double)spins[i] * time);
+    }
+
+    int iterations = maxEccentricity > 0.0f ? KEPLER_ITERATIONS : 0;
+    switch (kernel)
+    {
+    case KERNEL_AVX2:
+        solveAVX2(count, iterations);
+        break;
+    case KERNEL_SSE2:
+        solveSSE2(count, iterations);
+        break;
+    default:
+        solveScalar(0, count, iterations);
+        break;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        int parent = parents[i];
+        positionX[i] = offsetX[i] + (parent == ROOT ? 0.0f : positionX[parent]);
+        positionY[i] = offsetY[i] + (parent == ROOT ? 0.0f : positionY[parent]);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// scalar batch kernel (libm cos/sin), also used for the SIMD remainders
+///////////////////////////////////////////////////////////////////////////////
+void OrbitSystem::solveScalar(std::size_t first, std::size_t count, int iterations)
+{
+    for (std::size_t i = first; i < count; ++i)
+    {
+        float m = anomalies[i];
+        float e = eccentricities[i];
+        float sinE = sinf(m);
+        float cosE = cosf(m);
+        if (iterations > 0)
+        {
+            float anomaly = m + e * sinE;
+            for (int k = 0; k < iterations; ++k)
+                anomaly -= (anomaly - e * sinf(anomaly) - m) / (1.0f - e * cosf(anomaly));
+            sinE = sinf(anomaly);
+            cosE = cosf(anomaly);
+        }
+        offsetX[i] = semiMajor[i] * (cosE - e);
+        offsetY[i] = semiMinor[i] * sinE;
+    }
+}
+
+
+
+#ifdef SIMD_X86
+///////////////////////////////////////////////////////////////////////////////
+// SSE2 batch kernel: 4 bodies per iteration
+///////////////////////////////////////////////////////////////////////////////
+void OrbitSystem::solveSSE2(std::size_t count, int iterations)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 m = _mm_loadu_ps(&anomalies[i]);
+        __m128 e = _mm_loadu_ps(&eccentricities[i]);
+        __m128 sinE, cosE;
+        sincos4(m, &sinE, &cosE);
+        if (iterations > 0)
+        {
+            __m128 anomaly = _mm_add_ps(m, _mm_mul_ps(e, sinE));
+            for (int k = 0; k < iterations; ++k)
+            {
+                sincos4(anomaly, &sinE, &cosE);
+                __m128 f = _mm_sub_ps(_mm_sub_ps(anomaly, _mm_mul_ps(e, sinE)), m);
+                anomaly = _mm_sub_ps(anomaly, _mm_div_ps(f, _mm_sub_ps(one, _mm_mul_ps(e, cosE))));
+            }
+            sincos4(anomaly, &sinE, &cosE);
+        }
+        _mm_storeu_ps(&offsetX[i], _mm_mul_ps(_mm_loadu_ps(&semiMajor[i]), _mm_sub_ps(cosE, e)));
+        _mm_storeu_ps(&offsetY[i], _mm_mul_ps(_mm_loadu_ps(&semiMinor[i]), sinE));
+    }
+    solveScalar(i, count, iterations);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AVX2 batch kernel: 8 bodies per iteration
+///////////////////////////////////////////////////////////////////////////////
+SIMD_TARGET_AVX2
+void OrbitSystem::solveAVX2(std::size_t count, int iterations)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 m = _mm256_loadu_ps(&anomalies[i]);
+        __m256 e = _mm256_loadu_ps(&eccentricities[i]);
+        __m256 sinE, cosE;
+        sincos8(m, &sinE, &cosE);
+        if (iterations > 0)
+        {
+            __m256 anomaly = _mm256_fmadd_ps(e, sinE, m);
+            for (int k = 0; k < iterations; ++k)
+            {
+                sincos8(anomaly, &sinE, &cosE);
+                __m256 f = _mm256_sub_ps(_mm256_fnmadd_ps(e, sinE, anomaly), m);
+                anomaly = _mm256_sub_ps(anomaly, _mm256_div_ps(f, _mm256_fnmadd_ps(e, cosE, one)));
+            }
+            sincos8(anomaly, &sinE, &cosE);
+        }
+        _mm256_storeu_ps(&offsetX[i], _mm256_mul_ps(_mm256_loadu_ps(&semiMajor[i]), _mm256_sub_ps(cosE, e)));
+        _mm256_storeu_ps(&offsetY[i], _mm256_mul_ps(_mm256_loadu_ps(&semiMinor[i]), sinE));
+    }
+    solveScalar(i, count, iterations);
+}
+
+#else
+// no SIMD paths on this architecture; isKernelSupported() never selects them
+void OrbitSystem::solveSSE2(std::size_t count, int iterations)
+{
+    solveScalar(0, count, iterations);
+}
+
+void OrbitSystem::solveAVX2(std::size_t count, int iterations)
+{
+    solveScalar(0, count, iterations);
+}
+#endif
@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+// OrbitSystem.h
+// =============
+// Analytic (Kepler) orbits of a body hierarchy, stored as structure of arrays:
+// parent, semi-major axis (radius), eccentricity, mean motion (speed, rad/s),
+// mean anomaly at t = 0 (phase), axial tilt and spin speed. evaluate(t) solves
+// every orbit for time t in one batched pass, then accumulates the offsets
+// down the hierarchy; nothing is integrated, so any t can be evaluated
+// directly and the result does not drift.
+//
+// Per body: M = phase + speed * t, E - e sin(E) = M (Newton, fixed number of
+// steps, none when every orbit is circular), offset from the parent
+// (a (cos(E) - e), b sin(E)) with b = a sqrt(1 - e^2); the periapsis is on
+// the parent's +x axis. With e = 0 this is the (a cos(M), a sin(M)) circle of
+// transformations.cpp. Eccentricity is clamped to [0, 0.9].
+//
+// Bodies are added parent before child (addBody() only accepts an existing
+// parent), so the accumulation is one pass in index order: every level is
+// done before the next one reads it.
+//
+// The batched solve has SSE2 (4 bodies) and AVX2+FMA (8 bodies) paths with
+// the polynomial sincos of common/simd_sincos.h, selected at runtime like
+// WaveSet, and a scalar libm fallback. The anomalies and spin angles are
+// wrapped in double precision first, so t can grow without losing accuracy.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ORBIT_SYSTEM_H
+#define ORBIT_SYSTEM_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+#include "../common/simd_sincos.h"
+
+class OrbitSystem
+{
+public:
+    static const int ROOT = -1;             // parent of the top-level bodies (orbit the origin)
+
+    // batched kernel implementations
+    enum Kernel
+    {
+        KERNEL_AUTO = SIMD_KERNEL_AUTO,
+        KERNEL_SCALAR = SIMD_KERNEL_SCALAR,
+        KERNEL_SSE2 = SIMD_KERNEL_SSE2,
+        KERNEL_AVX2 = SIMD_KERNEL_AVX2
+    };
+
+    struct Orbit
+    {
+        int parent;
+        float radius;                       // semi-major axis, 0 for a body fixed on its parent
+        float eccentricity;
+        float speed;                        // mean motion, rad/s
+        float phase;                        // mean anomaly at t = 0, rad
+        float tilt;                         // axial tilt, rad (for the caller's model matrix)
+        float spin;                         // self rotation, rad/s
+    };
+
+    // ctor/dtor
+    OrbitSystem();
+    ~OrbitSystem() {}
+
+    void reserve(std::size_t count);
+    void clear();
+    int addBody(const Orbit& orbit);        // returns the body index, -1 if the parent is invalid
+    int getBodyCount() const { return (int)parents.size(); }
+    int getParent(int body) const { return parents[body]; }
+    float getTilt(int body) const { return tilts[body]; }
+
+    // solve every orbit for time t (seconds)
+    void evaluate(double time);
+
+    // results of the last evaluate(), one entry per body
+    glm::vec2 getOffset(int body) const { return glm::vec2(offsetX[body], offsetY[body]); }    // from the parent
+    glm::vec2 getPosition(int body) const { return glm::vec2(positionX[body], positionY[body]); }
+    float getSpinAngle(int body) const { return spinAngles[body]; }
+    const float* getPositionX() const { return positionX.data(); }
+    const float* getPositionY() const { return positionY.data(); }
+
+    // kernel used by evaluate() (KERNEL_AUTO picks the best one this CPU supports)
+    void setKernel(Kernel kernel) { this->kernel = (Kernel)simdSelectKernel((SimdKernel)kernel); }
+    Kernel getKernel() const { return kernel; }
+    static const char* getKernelName(Kernel kernel) { return simdKernelName((SimdKernel)kernel); }
+    static bool isKernelSupported(Kernel kernel) { return simdIsKernelSupported((SimdKernel)kernel); }
+
+private:
+    // batch kernels: offsets of bodies [0, count) from the wrapped anomalies
+    void solveScalar(std::size_t first, std::size_t count, int iterations);
+    void solveSSE2(std::size_t count, int iterations);
+    void solveAVX2(std::size_t count, int iterations);
+
+    Kernel kernel;
+    float maxEccentricity;
+
+    // orbital elements (SoA)
+    std::vector<int> parents;
+    std::vector<float> semiMajor;
+    std::vector<float> semiMinor;           // a * sqrt(1 - e^2)
+    std::vector<float> eccentricities;
+    std::vector<float> speeds;
+    std::vector<float> phases;
+    std::vector<float> tilts;
+    std::vector<float> spins;
+
+    // per evaluate()
+    std::vector<float> anomalies;           // mean anomaly wrapped to [-pi, pi)
+    std::vector<float> offsetX;
+    std::vector<float> offsetY;
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> spinAngles;          // wrapped to [-pi, pi)
+};
+
+#endif
@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+// SceneGraph.cpp
+// ==============
+// Flat transform hierarchy with dirty-flag propagation.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+#include <algorithm>
+#include <cstring>
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+SceneGraph::SceneGraph() : firstDirty(0)
+{
+}
+
+void SceneGraph::reserve(std::size_t count)
+{
+    parents.reserve(count);
+    locals.reserve(count);
+    worlds.reserve(count);
+    dirty.reserve(count);
+}
+
+void SceneGraph::clear()
+{
+    parents.clear();
+    locals.clear();
+    worlds.clear();
+    dirty.clear();
+    firstDirty = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// append a node; the parent must exist already, which keeps the arrays in
+// parent-before-child order. Returns the node index, -1 if parent is invalid
+///////////////////////////////////////////////////////////////////////////////
+int SceneGraph::addNode(int parent, const glm::mat4& local)
+{
+    int node = (int)parents.size();
+    if (parent < ROOT || parent >= node)
+        return -1;
+
+    parents.push_back(parent);
+    locals.push_back(local);
+    worlds.push_back(local);
+    dirty.push_back(1);
+    firstDirty = std::min(firstDirty, node);
+    return node;
+}
+
+void SceneGraph::setLocal(int node, const glm::mat4& local)
+{
+    if (std::memcmp(&locals[node], &local, sizeof(glm::mat4)) == 0)
+        return;
+
+    locals[node] = local;
+    dirty[node] = 1;
+    firstDirty = std::min(firstDirty, node);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// one pass from the first dirty node: a parent is always visited before its
+// children, so its flag already tells whether its world changed this pass.
+// The flags are cleared afterwards.
+///////////////////////////////////////////////////////////////////////////////
+int SceneGraph::update()
+{
+    int count = (int)parents.size();
+    int updated = 0;
+    for (int i = firstDirty; i < count; ++i)
+    {
+        int parent = parents[i];
+        if (!dirty[i] && (parent == ROOT || !dirty[parent]))
+            continue;
+
+        dirty[i] = 1;
+        worlds[i] = (parent == ROOT) ? locals[i] : worlds[parent] * locals[i];
+        ++updated;
+    }
+
+    if (firstDirty < count)
+        std::memset(&dirty[firstDirty], 0, count - firstDirty);
+    firstDirty = count;
+    return updated;
+}
@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////////////////////////////////
+// SceneGraph.h
+// ============
+// Flat transform hierarchy for orbital systems (sun -> planet -> moon ...).
+// Nodes are stored in parallel arrays (parent index, local, world, dirty flag)
+// in parent-before-child order: addNode() only accepts an existing parent, so
+// a node's index is always greater than its parent's. update() then
+// recomputes the world matrices in one linear pass, world = parentWorld *
+// local, and only for the nodes whose local changed or whose parent's world
+// was recomputed in the same pass (dirty-flag propagation). The pass starts
+// at the first dirty node; a frame where nothing moved costs nothing.
+// Shared parents are multiplied once, so even with every node moving the pass
+// takes about half the time of chaining the matrices by hand, and still less
+// with the setLocal() copies of every node added (scene_graph_benchmark.cpp);
+// static parts of the hierarchy cost nothing.
+//
+// Nodes are never removed; rebuild the graph (clear()) when the system
+// changes. No GL; positions are read from the translation column of the world
+// matrix (getWorldPosition()) instead of a mat4 x vec4.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+class SceneGraph
+{
+public:
+    static const int ROOT = -1;             // parent of the top-level nodes
+
+    // ctor/dtor
+    SceneGraph();
+    ~SceneGraph() {}
+
+    void reserve(std::size_t count);
+    void clear();
+
+    // new node under parent (ROOT or an existing node), dirty until the next update()
+    int addNode(int parent, const glm::mat4& local = glm::mat4(1.0f));
+    int getNodeCount() const { return (int)parents.size(); }
+    int getParent(int node) const { return parents[node]; }
+
+    // a local equal to the current one leaves the node clean
+    void setLocal(int node, const glm::mat4& local);
+    const glm::mat4& getLocal(int node) const { return locals[node]; }
+
+    // world matrices of the dirty nodes and their descendants, returns # of nodes recomputed
+    int update();
+    const glm::mat4& getWorld(int node) const { return worlds[node]; }       // valid after update()
+    glm::vec2 getWorldPosition(int node) const { return glm::vec2(worlds[node][3].x, worlds[node][3].y); }
+
+private:
+    std::vector<int> parents;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<unsigned char> dirty;       // local changed, or (during update()) world recomputed
+    int firstDirty;                         // getNodeCount() if nothing is dirty
+};
+
+#endif
@@ -0,0 +1,179 @@
+///////////////////////////////////////////////////////////////////////////////
+// ShapeBatch.cpp
+// ==============
+// 2D shape batcher: registry shape meshes + per-instance transform/material.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShapeBatch.h"
+#include <cstddef>
+
+const int FLOATS_PER_VERTEX = 8;
+const GLuint ATTRIB_TRANSFORM = 3;         // 4 locations, one per column
+const GLuint ATTRIB_MATERIAL = 7;
+const GLuint ATTRIB_SHAPE_PARAM = 8;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+ShapeBatch::ShapeBatch(MeshRegistry& meshes) : meshes(meshes), vao(0), instanceVbo(0), instanceCapacity(0), drawCount(0), instanceCount(0)
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the shape's geometry is the registry's unit mesh, uploaded once for every
+// user of (build, segmentCount) into the registry's shared buffers
+///////////////////////////////////////////////////////////////////////////////
+int ShapeBatch::addShape(MeshRegistry::MeshBuilder build, int segmentCount, GLenum mode)
+{
+    Shape shape;
+    shape.mode = mode;
+    shape.mesh = meshes.acquire(build, segmentCount);
+    shapes.push_back(shape);
+    queues.push_back(std::vector<Instance>());
+    return (int)shapes.size() - 1;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// one VAO for every shape: the shape attributes from the registry VBO/EBO
+// (all shapes share them), the instance attributes (divisor 1) from the
+// instance VBO
+///////////////////////////////////////////////////////////////////////////////
+void ShapeBatch::create()
+{
+    if (vao || shapes.empty())
+        return;
+
+    glGenBuffers(1, &instanceVbo);
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, shapes[0].mesh.vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shapes[0].mesh.ebo);
+
+    GLsizei stride = FLOATS_PER_VERTEX * sizeof(float);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    for (GLuint i = 0; i < 6; ++i)           // 4 transform columns + material + shape parameter
+    {
+        glEnableVertexAttribArray(ATTRIB_TRANSFORM + i);
+        glVertexAttribDivisor(ATTRIB_TRANSFORM + i, 1);
+    }
+    pointInstanceAttribs(0);
+    glBindVertexArray(0);
+}
+
+void ShapeBatch::release()
+{
+    for (std::size_t i = 0; i < shapes.size(); ++i)
+        meshes.release(shapes[i].mesh);
+    shapes.clear();
+    queues.clear();
+
+    if (vao)
+        glDeleteVertexArrays(1, &vao);
+    if (instanceVbo)
+        glDeleteBuffers(1, &instanceVbo);
+    vao = 0;
+    instanceVbo = 0;
+    instanceCapacity = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// per-frame instances
+///////////////////////////////////////////////////////////////////////////////
+void ShapeBatch::begin()
+{
+    for (std::size_t i = 0; i < queues.size(); ++i)
+        queues[i].clear();
+}
+
+void ShapeBatch::add(int shape, const glm::mat4& transform, int material, float shapeParam)
+{
+    if (shape < 0 || shape >= (int)queues.size())
+        return;
+
+    Instance instance;
+    instance.transform = transform;
+    instance.material = material;
+    instance.shapeParam = shapeParam;
+    queues[shape].push_back(instance);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// all instances go up in one write, grouped by shape; GL 3.3 has no base
+// instance, so the instance attributes are re-pointed at each shape's range
+// (the instance VBO stays bound), and the shape's mesh range is picked by
+// firstIndex/baseVertex
+///////////////////////////////////////////////////////////////////////////////
+void ShapeBatch::flush()
+{
+    drawCount = 0;
+    instanceCount = 0;
+    if (!vao)
+        return;
+
+    instances.clear();
+    for (std::size_t i = 0; i < queues.size(); ++i)
+        instances.insert(instances.end(), queues[i].begin(), queues[i].end());
+    if (instances.empty())
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    std::size_t size = instances.size() * sizeof(Instance);
+    if (instances.size() > instanceCapacity)
+        instanceCapacity = instances.size() * 2;
+    // new storage every frame (orphaning), no wait for the draws of the previous frame
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(Instance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, instances.data());
+
+    glBindVertexArray(vao);
+    std::size_t first = 0;
+    for (std::size_t i = 0; i < shapes.size(); ++i)
+    {
+        GLsizei count = (GLsizei)queues[i].size();
+        if (count == 0)
+            continue;
+
+        const Mesh& mesh = shapes[i].mesh;
+        pointInstanceAttribs(first);
+        glDrawElementsInstancedBaseVertex(shapes[i].mode, mesh.indexCount, GL_UNSIGNED_INT,
+                                          (void*)((std::size_t)mesh.firstIndex * sizeof(unsigned int)), count,
+                                          mesh.baseVertex);
+        first += count;
+        ++drawCount;
+    }
+    instanceCount = (int)instances.size();
+    glBindVertexArray(0);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// instance attributes at the firstInstance-th Instance of the bound instance VBO
+///////////////////////////////////////////////////////////////////////////////
+void ShapeBatch::pointInstanceAttribs(std::size_t firstInstance) const
+{
+    std::size_t base = firstInstance * sizeof(Instance);
+    for (GLuint i = 0; i < 4; ++i)
+    {
+        glVertexAttribPointer(ATTRIB_TRANSFORM + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                              (void*)(base + offsetof(Instance, transform) + i * sizeof(glm::vec4)));
+    }
+    glVertexAttribIPointer(ATTRIB_MATERIAL, 1, GL_INT, sizeof(Instance), (void*)(base + offsetof(Instance, material)));
+    glVertexAttribPointer(ATTRIB_SHAPE_PARAM, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(base + offsetof(Instance, shapeParam)));
+}
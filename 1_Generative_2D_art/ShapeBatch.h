@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// ShapeBatch.h
+// ============
+// 2D shape batcher: every shape (circle, dashed orbit, ...) is a unit mesh of
+// a MeshRegistry, i.e. a range of the registry's one shared VBO + EBO (the
+// same data the per-object draws use), and the objects drawn each frame are
+// per-instance data (transform + material ID). A frame is
+//      begin(); add(shape, transform, material) ...; flush();
+// and flush() binds one VAO and issues one glDrawElementsInstancedBaseVertex
+// per shape in use, whatever the number of objects: thousands of bodies on a
+// unit circle plus the earth and moon rings (two segment counts) are 3 draw
+// calls, or 1 when every shape is the same quad (SDF shapes in 5.2.batch.fs).
+// Scale the transform instead of adding a shape per radius.
+//
+// Vertex layout (8 floats, as MeshRegistry):
+//      0 position (vec3), 1 color (vec3), 2 texcoord (vec2)
+// Instance layout: 3-6 transform (mat4), 7 material (int), 8 shape parameter (float)
+//
+// Shapes are added before create() and hold a registry reference until
+// release(); like the other GL classes, addShape(), create(), flush() and
+// release() need the context current, the destructor does not touch GL.
+// The registry must outlive the batch.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHAPE_BATCH_H
+#define SHAPE_BATCH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "MeshRegistry.h"
+
+class ShapeBatch
+{
+public:
+    struct Instance
+    {
+        glm::mat4 transform;
+        int material;
+        float shapeParam;                   // meaning up to the shader, e.g. the dash count of an orbit ring
+    };
+
+    // ctor/dtor
+    explicit ShapeBatch(MeshRegistry& meshes);
+    ~ShapeBatch() {}
+    ShapeBatch(const ShapeBatch&) = delete;
+    ShapeBatch& operator=(const ShapeBatch&) = delete;
+
+    // acquire the unit mesh of (build, segmentCount) from the registry, returns its shape ID; before create()
+    int addShape(MeshRegistry::MeshBuilder build, int segmentCount, GLenum mode);
+    int getShapeCount() const { return (int)shapes.size(); }
+
+    void create();                          // one VAO: the registry VBO/EBO + the instance VBO
+    void release();                         // also returns the meshes to the registry and drops the shapes
+    bool isCreated() const { return vao != 0; }
+
+    // per frame
+    void begin();                           // drop the instances of the previous frame
+    void add(int shape, const glm::mat4& transform, int material, float shapeParam = 0.0f);
+    void flush();                           // upload all instances once, one instanced draw per shape in use
+    int getDrawCount() const { return drawCount; }          // draw calls of the last flush()
+    int getInstanceCount() const { return instanceCount; }  // objects of the last flush()
+
+private:
+    struct Shape
+    {
+        GLenum mode;                        // GL_TRIANGLES, GL_LINES, ...
+        Mesh mesh;                          // range of the registry buffers, owned by the registry
+    };
+
+    void pointInstanceAttribs(std::size_t firstInstance) const;
+
+    MeshRegistry& meshes;
+    std::vector<Shape> shapes;
+    std::vector<std::vector<Instance> > queues;             // instances added this frame, per shape
+    std::vector<Instance> instances;        // the queues back to back, as uploaded
+    unsigned int vao;
+    unsigned int instanceVbo;
+    std::size_t instanceCapacity;           // # of instances the instance VBO holds
+    int drawCount;
+    int instanceCount;
+};
+
+#endif
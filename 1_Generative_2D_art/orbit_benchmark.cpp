@@ -0,0 +1,121 @@
+// Orbit system benchmark
+// OrbitSystem::evaluate() for procedural star systems of 10k and 100k bodies
+// (no window or GL context needed), per kernel, with circular orbits (no
+// Kepler iterations) and eccentric ones, and the max position error against
+// a double precision solve of the same elements
+#include "OrbitSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+const int PLANETS_PER_STAR = 9;
+const int MOONS_PER_PLANET = 10;            // 100 bodies per system
+
+// star -> planets -> moons, the stars on a wide ring around the origin
+std::vector<OrbitSystem::Orbit> buildSystems(int bodyCount, bool eccentric)
+{
+    std::vector<OrbitSystem::Orbit> elements;
+    int starCount = bodyCount / (1 + PLANETS_PER_STAR * (1 + MOONS_PER_PLANET));
+    for (int s = 0; s < starCount; ++s)
+    {
+        int starIndex = (int)elements.size();
+        OrbitSystem::Orbit star = { OrbitSystem::ROOT, 50.0f, 0.0f, 0.001f, s * 6.2831853f / starCount, 0.0f, 0.0f };
+        elements.push_back(star);
+        for (int p = 0; p < PLANETS_PER_STAR; ++p)
+        {
+            int planetIndex = (int)elements.size();
+            float e = eccentric ? 0.05f + 0.09f * p : 0.0f;     // up to 0.77
+            OrbitSystem::Orbit planet = { starIndex, 0.3f + 0.1f * p, e, 0.3f / (1.0f + p), p * 0.7f, 0.4f, 3.0f };
+            elements.push_back(planet);
+            for (int m = 0; m < MOONS_PER_PLANET; ++m)
+            {
+                OrbitSystem::Orbit moon = { planetIndex, 0.02f + 0.005f * m, eccentric ? 0.02f * m : 0.0f,
+                                            1.2f + 0.1f * m, m * 1.3f, 0.0f, 0.3f };
+                elements.push_back(moon);
+            }
+        }
+    }
+    return elements;
+}
+
+// double precision reference: same elements, libm and a converged Newton solve
+void solveReference(const std::vector<OrbitSystem::Orbit>& elements, double time,
+                    std::vector<double>& x, std::vector<double>& y)
+{
+    const double TWO_PI = 6.283185307179586;
+    int count = (int)elements.size();
+    x.assign(count, 0.0);
+    y.assign(count, 0.0);
+    for (int i = 0; i < count; ++i)
+    {
+        const OrbitSystem::Orbit& o = elements[i];
+        double e = std::min(std::max((double)o.eccentricity, 0.0), 0.9);
+        double m = fmod((double)o.phase + (double)o.speed * time, TWO_PI);
+        double anomaly = m;
+        for (int k = 0; k < 50; ++k)
+            anomaly -= (anomaly - e * sin(anomaly) - m) / (1.0 - e * cos(anomaly));
+        double a = o.radius;
+        double b = a * sqrt(1.0 - e * e);
+        x[i] = a * (cos(anomaly) - e) + (o.parent == OrbitSystem::ROOT ? 0.0 : x[o.parent]);
+        y[i] = b * sin(anomaly) + (o.parent == OrbitSystem::ROOT ? 0.0 : y[o.parent]);
+    }
+}
+
+// average ms of one evaluate(), repeated until ~200 ms have passed
+double timeEvaluate(OrbitSystem& orbits)
+{
+    int runs = 0;
+    double total = 0.0;
+    while (total < 200.0 || runs < 3)
+    {
+        auto start = std::chrono::steady_clock::now();
+        orbits.evaluate(1000.0 + runs * (1.0 / 60.0));
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        ++runs;
+    }
+    return total / runs;
+}
+
+int main()
+{
+    const int bodyCounts[] = { 10000, 100000 };
+    const OrbitSystem::Kernel kernels[] = { OrbitSystem::KERNEL_SCALAR, OrbitSystem::KERNEL_SSE2, OrbitSystem::KERNEL_AVX2 };
+
+    std::printf("%8s %10s %8s %10s %12s\n", "bodies", "orbits", "kernel", "ms", "max error");
+    for (int bodyCount : bodyCounts)
+    {
+        for (int eccentric = 0; eccentric < 2; ++eccentric)
+        {
+            std::vector<OrbitSystem::Orbit> elements = buildSystems(bodyCount, eccentric != 0);
+            OrbitSystem orbits;
+            orbits.reserve(elements.size());
+            for (const OrbitSystem::Orbit& orbit : elements)
+                orbits.addBody(orbit);
+
+            const double checkTime = 1234.5;
+            std::vector<double> refX, refY;
+            solveReference(elements, checkTime, refX, refY);
+
+            for (OrbitSystem::Kernel kernel : kernels)
+            {
+                if (!OrbitSystem::isKernelSupported(kernel))
+                    continue;
+                orbits.setKernel(kernel);
+                double ms = timeEvaluate(orbits);
+
+                orbits.evaluate(checkTime);
+                double maxError = 0.0;
+                for (int i = 0; i < orbits.getBodyCount(); ++i)
+                {
+                    glm::vec2 p = orbits.getPosition(i);
+                    maxError = std::max(maxError, std::max(std::fabs(p.x - refX[i]), std::fabs(p.y - refY[i])));
+                }
+                std::printf("%8d %10s %8s %10.3f %12.3g\n", orbits.getBodyCount(), eccentric ? "eccentric" : "circular",
+                            OrbitSystem::getKernelName(kernel), ms, maxError);
+            }
+        }
+    }
+    return 0;
+}
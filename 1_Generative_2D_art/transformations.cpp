@@ -5,20 +5,39 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <learnopengl/filesystem.h>
-#include <learnopengl/shader_s.h>
+#include "../common/shader_cached.h"
+#include "ShapeBatch.h"
+#include "SceneGraph.h"
+#include "OrbitSystem.h"
+#include "MeshRegistry.h"
 #include <iostream>
 #include <vector>
+#include <algorithm>
 #include <cmath> 
 
-struct Mesh {
-    unsigned int vao, vbo, ebo;
-    int indexCount;
+// per-frame data of 5.1.transform.fs, one buffer write per frame (std140, must match the Frame block)
+struct FrameUniforms
+{
+    glm::vec2 mousePos;
+    float time;
+    float padding;
+    glm::vec2 viewport;         // framebuffer size, the space of gl_FragCoord
+    float padding2[2];
 };
+const unsigned int FRAME_BINDING = 0;
+
+// material IDs of the batched renderer (5.2.batch.fs)
+const int MATERIAL_SUN = 0;     // generative pattern
+const int MATERIAL_LINE = 1;    // vertex color (orbit lines)
+const int MATERIAL_TEXTURE = 2; // + layer of the texture array: 0 earth, 1 moon
 
-Mesh createCircle(int segmentCount, float radius) {
+// dashed orbit rings, every other segment is a dash (SDF rings: segments / 2 dashes)
+const int EARTH_ORBIT_SEGMENTS = 100;
+const int MOON_ORBIT_SEGMENTS = 60;
+
+// geometry of a filled circle into empty vectors (also the shapes of the batched renderer)
+void buildCircle(int segmentCount, float radius, std::vector<float>& vertices, std::vector<unsigned int>& indices) {
     const float PI = 3.14159265359f;
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
     // --- 1. Generate Vertices [Pos(3), Color(3), Tex(2)] ---
     // 1.1 Center Point
     vertices.insert(vertices.end(), { 0.0f, 0.0f, 0.0f }); // Pos
@@ -47,33 +66,24 @@ Mesh createCircle(int segmentCount, float radius) {
         indices.push_back(i);
         indices.push_back(i + 1);
     }
-    // --- 3. OpenGL Buffers ---
-    unsigned int VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-    // Attribute Pointers (Stride: 8 * float)
-    GLsizei stride = 8 * sizeof(float);
-    // Position (Location 0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-    glEnableVertexAttribArray(0);
-    // Color (Location 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // Texture Coord (Location 2)
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glBindVertexArray(0);
-    return { VAO, VBO, EBO, (int)indices.size() };
 }
-Mesh createDashedCircle(int segmentCount, float radius) {
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+// quad [-radius, radius]^2 with the UVs of buildCircle(): the analytic (SDF) shapes of 5.2.batch.fs
+// (no segments, the count only keys the mesh in MeshRegistry)
+void buildQuad(int segmentCount, float radius, std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+    const float corners[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+    for (int i = 0; i < 4; i++) {
+        vertices.insert(vertices.end(), { corners[i][0] * radius, corners[i][1] * radius, 0.0f });      // Pos
+        vertices.insert(vertices.end(), { 1.0f, 1.0f, 1.0f });                                          // Color (orbit lines)
+        vertices.insert(vertices.end(), { corners[i][0] * 0.5f + 0.5f, corners[i][1] * 0.5f + 0.5f });  // UV
+    }
+    indices.insert(indices.end(), { 0, 1, 2, 0, 2, 3 });
+}
+// shared unit circle (MeshRegistry); the radius goes into the transform
+Mesh createCircle(MeshRegistry& meshes, int segmentCount) {
+    return meshes.acquire(buildCircle, segmentCount);
+}
+// geometry of a dashed circle (GL_LINES) into empty vectors
+void buildDashedCircle(int segmentCount, float radius, std::vector<float>& vertices, std::vector<unsigned int>& indices) {
     const float PI = 3.14159265359f;
 
     // 1. Generate Vertices (͹ǧ ҵͧͺ)
@@ -101,32 +111,58 @@ Mesh createDashedCircle(int segmentCount, float radius) {
         indices.push_back(i);
         indices.push_back((i + 1) % segmentCount);
     }
+}
+// shared unit dashed circle (MeshRegistry), as createCircle()
+Mesh createDashedCircle(MeshRegistry& meshes, int segmentCount) {
+    return meshes.acquire(buildDashedCircle, segmentCount);
+}
 
-    // 3. OpenGL Buffers (Copy Logic )
-    unsigned int VAO, VBO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    GLsizei stride = 8 * sizeof(float);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+// one RGBA layer per image, resampled (nearest) to size x size since all the
+// layers of an array have the same size
+unsigned int loadTextureArray(const std::vector<std::string>& paths, int size) {
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, (GLsizei)paths.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    std::vector<unsigned char> layer(size * size * 4);
+    stbi_set_flip_vertically_on_load(true);
+    for (size_t i = 0; i < paths.size(); i++) {
+        int width, height, nrChannels;
+        unsigned char* data = stbi_load(paths[i].c_str(), &width, &height, &nrChannels, 4);
+        if (!data) {
+            std::cout << "Failed to load texture " << paths[i] << std::endl;
+            continue;
+        }
+        for (int y = 0; y < size; y++) {
+            const unsigned char* row = data + (size_t)(y * height / size) * width * 4;
+            for (int x = 0; x < size; x++) {
+                const unsigned char* texel = row + (size_t)(x * width / size) * 4;
+                std::copy(texel, texel + 4, &layer[((size_t)y * size + x) * 4]);
+            }
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)i, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, layer.data());
+        stbi_image_free(data);
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    return texture;
+}
 
-    glBindVertexArray(0);
+// extra body i on a circular orbit around parent (the sun)
+OrbitSystem::Orbit getAsteroidOrbit(int i, int parent) {
+    // spread with irrational steps so no two bodies share an orbit
+    OrbitSystem::Orbit orbit = { parent, 0.35f + 0.6f * fmodf(i * 0.618034f, 1.0f), 0.0f,
+                                 0.1f + 0.4f * fmodf(i * 0.414214f, 1.0f), i * 2.39996f, 0.0f, 0.0f };
+    return orbit;
+}
 
-    // ˵: indexCount  return 仨繨ӹǹشͧ ӹǹ
-    return { VAO, VBO, EBO, (int)indices.size() };
+// size of extra body i, for a unit circle
+float getAsteroidRadius(int i) {
+    return 0.008f + 0.012f * fmodf(i * 0.732051f, 1.0f);
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -135,6 +171,9 @@ void processInput(GLFWwindow *window);
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 800;
+bool batchedRendering = true;   // all bodies and orbits in 1 (SDF) or 3 (tessellated) instanced draws (ShapeBatch); false: one draw per object
+int asteroidCount = 0;          // extra bodies orbiting the sun, to compare both paths at scale
+bool sdfShapes = true;          // batched: every body and orbit is one quad, edges computed in 5.2.batch.fs (1 draw); false: tessellated shapes
 
 int main()
 {
@@ -171,77 +210,167 @@ int main()
 
     // build and compile our shader zprogram
     // ------------------------------------
-    Shader ourShader("5.1.transform.vs", "5.1.transform.fs");
+    CachedShader ourShader("5.1.transform.vs", "5.1.transform.fs");
+    CachedShader batchShader("5.2.batch.vs", "5.2.batch.fs");
 
     // --- 1. Generate Vertices ---
-    // Create the circle once
-    Mesh sunCircle = createCircle(64, 0.3f);
-    Mesh earthCircle = createCircle(64, 0.2f);
-    Mesh moonCircle = createCircle(64, 0.1f);
-
-    // ҧǧ⤨ (Orbit Lines)
-    //  1.0f ǧ⤨š (ͧҡѺ orbitRadius ͧš Loop)
-    Mesh earthOrbitLine = createDashedCircle(100, 0.75f);
-    //  0.5f ǧ⤨ôǧѹ (ͧҡѺ orbitRadius ͧǧѹ Loop)
-    Mesh moonOrbitLine = createDashedCircle(60, 0.25f);
-
-    // load and create a texture 
-    // -------------------------
-    unsigned int texture1, texture2;
-    // texture 1
-    // ---------
-    glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-    // set the texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    // set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // load image, create texture and generate mipmaps
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
-    unsigned char* data = stbi_load(FileSystem::getPath("resources/textures/earth.png").c_str(), &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+    // Create the circle once: one shared unit mesh, sized by the transforms;
+    // only the path in use acquires its meshes (ShapeBatch from the same registry)
+    MeshRegistry meshes;
+    Mesh sunCircle = {}, earthCircle = {}, moonCircle = {};
+    Mesh earthOrbitLine = {}, moonOrbitLine = {}, asteroidCircle = {};
+    if (!batchedRendering) {
+        sunCircle = createCircle(meshes, 64);
+        earthCircle = createCircle(meshes, 64);
+        moonCircle = createCircle(meshes, 64);
+
+        // ҧǧ⤨ (Orbit Lines)
+        //  1.0f ǧ⤨š (ͧҡѺ orbitRadius ͧš Loop)
+        earthOrbitLine = createDashedCircle(meshes, EARTH_ORBIT_SEGMENTS);
+        //  0.5f ǧ⤨ôǧѹ (ͧҡѺ orbitRadius ͧǧѹ Loop)
+        moonOrbitLine = createDashedCircle(meshes, MOON_ORBIT_SEGMENTS);
+        asteroidCircle = createCircle(meshes, 16);
     }
-    else
-    {
-        std::cout << "Failed to load texture" << std::endl;
+
+    // batched renderer: unit shapes, the radius goes into each object's transform
+    ShapeBatch batch(meshes);
+    int bodyShape = -1, earthLineShape = -1, moonLineShape = -1;
+    if (batchedRendering) {
+        if (sdfShapes) {
+            // 4 vertices per body instead of 66, no segment count: disks and dashed rings on the same quad,
+            // the dash count of a ring goes with its instance
+            int quadShape = batch.addShape(buildQuad, 0, GL_TRIANGLES);
+            bodyShape = earthLineShape = moonLineShape = quadShape;
+        }
+        else {
+            bodyShape = batch.addShape(buildCircle, 64, GL_TRIANGLES);
+            earthLineShape = batch.addShape(buildDashedCircle, EARTH_ORBIT_SEGMENTS, GL_LINES);
+            moonLineShape = batch.addShape(buildDashedCircle, MOON_ORBIT_SEGMENTS, GL_LINES);
+        }
+        batch.create();
     }
-    stbi_image_free(data);
-
-    // texture 2
-    // ---------
-    glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-    // set the texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    // set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // load image, create texture and generate mipmaps
-    data = stbi_load(FileSystem::getPath("resources/textures/moon.png").c_str(), &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        // note that the awesomeface.png has transparency and thus an alpha channel, so make sure to tell OpenGL the data type is of GL_RGBA
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+
+    // orbital elements, solved for all bodies at once each frame; the sun stays
+    // on its node (radius 0), the earth and the asteroids orbit it, the moon the earth
+    OrbitSystem orbits;
+    orbits.reserve(3 + asteroidCount);
+    OrbitSystem::Orbit sunOrbit = { OrbitSystem::ROOT, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    OrbitSystem::Orbit earthOrbit = { 0, 0.75f, 0.0f, 0.3f, 0.0f, glm::radians(-23.5f), 3.0f };
+    OrbitSystem::Orbit moonOrbit = { 0, 0.25f, 0.0f, 1.2f, 0.0f, 0.0f, 0.3f };
+    int sunBody = orbits.addBody(sunOrbit);
+    earthOrbit.parent = sunBody;
+    int earthBody = orbits.addBody(earthOrbit);
+    moonOrbit.parent = earthBody;
+    int moonBody = orbits.addBody(moonOrbit);
+    std::vector<int> asteroidBodies;
+    std::vector<float> asteroidRadii;
+    for (int i = 0; i < asteroidCount; i++) {
+        asteroidBodies.push_back(orbits.addBody(getAsteroidOrbit(i, sunBody)));
+        asteroidRadii.push_back(getAsteroidRadius(i));
     }
-    else
-    {
-        std::cout << "Failed to load texture" << std::endl;
+
+    // scene graph, every node after its parent:
+    //   screen (aspect) -> sun -> earth orbit -> earth (tilt + spin)
+    //                          |             -> moon orbit -> moon (spin)
+    //                          -> asteroids
+    // the orbit lines are drawn at the sun and the earth orbit nodes
+    SceneGraph scene;
+    scene.reserve(6 + asteroidCount);
+    int screenNode = scene.addNode(SceneGraph::ROOT);
+    int sunNode = scene.addNode(screenNode);
+    int earthOrbitNode = scene.addNode(sunNode);
+    int earthNode = scene.addNode(earthOrbitNode);
+    int moonOrbitNode = scene.addNode(earthOrbitNode);
+    int moonNode = scene.addNode(moonOrbitNode);
+    std::vector<int> asteroidNodes;
+    for (int i = 0; i < asteroidCount; i++)
+        asteroidNodes.push_back(scene.addNode(sunNode));
+
+    // load and create a texture: two 2D textures for the per-object path, one
+    // array for the batched path, whichever is in use
+    // -------------------------
+    unsigned int texture1 = 0, texture2 = 0, textureArray = 0;
+    if (!batchedRendering) {
+        // texture 1
+        // ---------
+        glGenTextures(1, &texture1);
+        glBindTexture(GL_TEXTURE_2D, texture1);
+        // set the texture wrapping parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // set texture filtering parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // load image, create texture and generate mipmaps
+        int width, height, nrChannels;
+        stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
+        unsigned char* data = stbi_load(FileSystem::getPath("resources/textures/earth.png").c_str(), &width, &height, &nrChannels, 0);
+        if (data)
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        else
+        {
+            std::cout << "Failed to load texture" << std::endl;
+        }
+        stbi_image_free(data);
+
+        // texture 2
+        // ---------
+        glGenTextures(1, &texture2);
+        glBindTexture(GL_TEXTURE_2D, texture2);
+        // set the texture wrapping parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // set texture filtering parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // load image, create texture and generate mipmaps
+        data = stbi_load(FileSystem::getPath("resources/textures/moon.png").c_str(), &width, &height, &nrChannels, 0);
+        if (data)
+        {
+            // note that the awesomeface.png has transparency and thus an alpha channel, so make sure to tell OpenGL the data type is of GL_RGBA
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        else
+        {
+            std::cout << "Failed to load texture" << std::endl;
+        }
+        stbi_image_free(data);
+
+        // tell opengl for each sampler to which texture unit it belongs to (only has to be done once)
+        // -------------------------------------------------------------------------------------------
+        ourShader.use();
+        ourShader.setInt("texture1", 0);
+        ourShader.setInt("texture2", 1);
+    }
+    else {
+        // earth and moon as the layers of one texture array for the batched renderer
+        std::vector<std::string> texturePaths;
+        texturePaths.push_back(FileSystem::getPath("resources/textures/earth.png"));
+        texturePaths.push_back(FileSystem::getPath("resources/textures/moon.png"));
+        textureArray = loadTextureArray(texturePaths, 512);
+    }
+    batchShader.use();
+    batchShader.setInt("uTextures", 0);
+    batchShader.setBool("uSdfShapes", sdfShapes);
+    // the SDF edges are partial coverage (alpha)
+    if (batchedRendering && sdfShapes) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
-    stbi_image_free(data);
 
-    // tell opengl for each sampler to which texture unit it belongs to (only has to be done once)
-    // -------------------------------------------------------------------------------------------
-    ourShader.use();
-    ourShader.setInt("texture1", 0);
-    ourShader.setInt("texture2", 1);
+    // uniform handles, resolved once instead of every frame
+    // -----------------------------------------------------
+    int transformLoc = ourShader.location("transform");
+    int centerLoc = ourShader.location("uCenter");
+    int useTextureLoc = ourShader.location("useTexture");
+    ourShader.bindBlock("Frame", FRAME_BINDING);
+    batchShader.bindBlock("Frame", FRAME_BINDING);
+    UniformBuffer<FrameUniforms> frameUBO(FRAME_BINDING);
+    FrameUniforms frame = {};
 
     // render loop
     // -----------
@@ -256,15 +385,22 @@ int main()
         glClear(GL_COLOR_BUFFER_BIT);
 
 		// set time uniform
-        ourShader.use();
         float timeValue = glfwGetTime();
-        ourShader.setFloat("iTime", timeValue);
 
         // bind textures on corresponding texture units
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture2);
+        if (batchedRendering) {
+            batchShader.use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
+            batch.begin();
+        }
+        else {
+            ourShader.use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, texture1);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, texture2);
+        }
 
 		// Get mouse position in NDC
         double xpos, ypos;
@@ -278,138 +414,167 @@ int main()
         float xNDC = (2.0f * (float)xpos / width) - 1.0f;
         float yNDC = 1.0f - (2.0f * (float)ypos / height);
 
-		// Set mouse position uniform (in screen coordinates)
-        int mouseLoc = glGetUniformLocation(ourShader.ID, "uMousePos");
-        glUniform2f(mouseLoc, (float)xpos, (float)(height - ypos));
-
 		// Get framebuffer size for correct gl_FragCoord mapping
         int currentWidth, currentHeight;
         glfwGetFramebufferSize(window, &currentWidth, &currentHeight); 
 
-		// Set center position uniform (will be updated for Earth and Moon)
-        int CenterLoc = glGetUniformLocation(ourShader.ID, "uCenter");
+		// Upload time, mouse position (in screen coordinates) and framebuffer size in one write
+        frame.mousePos = glm::vec2((float)xpos, (float)(height - ypos));
+        frame.time = timeValue;
+        frame.viewport = glm::vec2((float)currentWidth, (float)currentHeight);
+        frameUBO.update(frame);
 
         // Correct for aspect ratio
         float aspect = (float)width / (float)height;
 
+        // --- locals of the scene graph (a node set to the same local stays clean) ---
+        scene.setLocal(screenNode, glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / aspect, 1.0f, 1.0f)));
+
         // 1. ҴǧҷԵ (çҧ / )
-        glm::mat4 sunTransform = glm::mat4(1.0f);
-        sunTransform = glm::translate(sunTransform, glm::vec3(xNDC, yNDC, 0.0f));
-        sunTransform = glm::scale(sunTransform, glm::vec3(1.0f / aspect, 1.0f, 1.0f));
-        ourShader.setInt("useTexture", 0); 
-        unsigned int transformLoc = glGetUniformLocation(ourShader.ID, "transform");
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(sunTransform));
-        glBindVertexArray(sunCircle.vao);
-        glDrawElements(GL_TRIANGLES, sunCircle.indexCount, GL_UNSIGNED_INT, 0);
+        scene.setLocal(sunNode, glm::translate(glm::mat4(1.0f), glm::vec3(xNDC * aspect, yNDC, 0.0f)));
 
+        // 2.-3. every orbit for this frame in one batched pass (OrbitSystem)
+        orbits.evaluate(timeValue);
 
         // 2. Ҵš (⤨ͺǧҷԵ +  Texture)
-        // bind textures on corresponding texture units
-        glm::mat4 earthTransform = glm::mat4(1.0f);
-        // --- ӴѺäٳ Matrix Ӥѭҡ (ҹҡҧ鹺  仫) ---
-        float orbitRadius = 0.75f; // ҧҡǧҷԵ
-        float orbitSpeed = 0.3f;
-        float selfRotationSpeed = 3.0f;
-        // 1. Scale  Aspect Ratio (ش Matrix Stack)
-        earthTransform = glm::scale(earthTransform, glm::vec3(1.0f / aspect, 1.0f, 1.0f));
-        // 2. ҴǧҷԵ (شٹҧ⤨)
-        earthTransform = glm::translate(earthTransform, glm::vec3(xNDC * aspect, yNDC, 0.0f));
-        // 3. ⤨ (Orbit)
-        //  Matrix ¡ͷǧ (ҡ) ǧẺ
-        float orbitAngle = timeValue * orbitSpeed;
-        // ҧǧ: x = a cos(t), y = b sin(t)
-        float earthX = cos(orbitAngle) * orbitRadius;
-        float earthY = sin(orbitAngle) * orbitRadius * 1.0f; // 0.9 ҡǧչԴ
-        earthTransform = glm::translate(earthTransform, glm::vec3(earthX, earthY, 0.0f));
+        glm::vec2 earthOffset = orbits.getOffset(earthBody);
+        scene.setLocal(earthOrbitNode, glm::translate(glm::mat4(1.0f), glm::vec3(earthOffset, 0.0f)));
         // 4. ͧ᡹§ (Axial Tilt)
         // §᡹ 23.5 ͧ (ͺ᡹ Z ͧẺ 2D)
-        earthTransform = glm::rotate(earthTransform, glm::radians(-23.5f), glm::vec3(0.0f, 0.0f, 1.0f)); // §᡹
+        glm::mat4 earthLocal = glm::rotate(glm::mat4(1.0f), orbits.getTilt(earthBody), glm::vec3(0.0f, 0.0f, 1.0f));
         // 5. عͺͧ (Rotation)
         // ѧࡵ: عͺ᡹ Y ͧ Earth (觵͹§)
-        earthTransform = glm::rotate(earthTransform, timeValue * selfRotationSpeed, glm::vec3(0.0f, 1.0f, 0.0f));
-        // 1. ҵ˹š NDC (-1 ֧ 1)
-        glm::vec4 earthPosNDC = earthTransform * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-        // 2. ŧ繾ԡѴ˹Ҩ (Screen Coordinates) ˹ǡѺ gl_FragCoord
-        float screenEarthX = (earthPosNDC.x + 1.0f) * 0.5f * currentWidth;
-        float screenEarthY = (earthPosNDC.y + 1.0f) * 0.5f * currentHeight;
-        glUniform2f(CenterLoc, screenEarthX, screenEarthY);
-        ourShader.setInt("useTexture", 1); // Դ Texture
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(earthTransform));
-        glBindVertexArray(earthCircle.vao); // ǧѹ ѹ袹Ҵҧѹ
-        glDrawElements(GL_TRIANGLES, earthCircle.indexCount, GL_UNSIGNED_INT, 0);
-
+        earthLocal = glm::rotate(earthLocal, orbits.getSpinAngle(earthBody), glm::vec3(0.0f, 1.0f, 0.0f));
+        scene.setLocal(earthNode, earthLocal);
 
 		// 3. Ҵǧѹ (⤨ͺš +  Texture)
-        glm::mat4 moonTransform = glm::mat4(1.0f);
-        orbitRadius = 0.25f; // ҧҡš
-        orbitSpeed = 1.2f;
-        selfRotationSpeed = 0.3f;
-        moonTransform = glm::scale(moonTransform, glm::vec3(1.0f / aspect, 1.0f, 1.0f));
-        moonTransform = glm::translate(moonTransform, glm::vec3(earthPosNDC.x * aspect, earthPosNDC.y, 0.0f));
-        orbitAngle = timeValue * orbitSpeed;
-        float moonX = cos(orbitAngle) * orbitRadius;
-        float moonY = sin(orbitAngle) * orbitRadius * 1.0f;
-        moonTransform = glm::translate(moonTransform, glm::vec3(moonX, moonY, 0.0f));
-        // 4. ͧ᡹§ (Axial Tilt)
-        moonTransform = glm::rotate(moonTransform, glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        glm::vec2 moonOffset = orbits.getOffset(moonBody);
+        scene.setLocal(moonOrbitNode, glm::translate(glm::mat4(1.0f), glm::vec3(moonOffset, 0.0f)));
         // 5. عͺͧ (Rotation)
         // ѧࡵ: عͺ᡹ Z ͧ Moon
-        moonTransform = glm::rotate(moonTransform, timeValue * selfRotationSpeed, glm::vec3(0.0f, 0.0f, 1.0f));
+        scene.setLocal(moonNode, glm::rotate(glm::mat4(1.0f), orbits.getSpinAngle(moonBody), glm::vec3(0.0f, 0.0f, 1.0f)));
+
+        // extra bodies, children of the sun
+        for (int i = 0; i < asteroidCount; i++) {
+            glm::mat4 asteroidLocal = glm::translate(glm::mat4(1.0f), glm::vec3(orbits.getOffset(asteroidBodies[i]), 0.0f));
+            scene.setLocal(asteroidNodes[i], glm::scale(asteroidLocal, glm::vec3(asteroidRadii[i])));
+        }
+
+        // world matrices of the changed subtrees only, one pass parent before child
+        scene.update();
+
+
+        // --- draw ---
+        glm::mat4 sunTransform = glm::scale(scene.getWorld(sunNode), glm::vec3(0.3f));
+        if (batchedRendering) {
+            batch.add(bodyShape, sunTransform, MATERIAL_SUN);
+        }
+        else {
+            ourShader.setInt(useTextureLoc, 0); 
+            ourShader.setMat4(transformLoc, sunTransform);
+            drawMesh(sunCircle, GL_TRIANGLES);
+        }
+
+
+        glm::mat4 earthTransform = glm::scale(scene.getWorld(earthNode), glm::vec3(0.2f));
+        // 1. ҵ˹š NDC (-1 ֧ 1)
+        glm::vec2 earthPosNDC = scene.getWorldPosition(earthNode);
+        // 2. ŧ繾ԡѴ˹Ҩ (Screen Coordinates) ˹ǡѺ gl_FragCoord
+        float screenEarthX = (earthPosNDC.x + 1.0f) * 0.5f * currentWidth;
+        float screenEarthY = (earthPosNDC.y + 1.0f) * 0.5f * currentHeight;
+        if (batchedRendering) {
+            batch.add(bodyShape, earthTransform, MATERIAL_TEXTURE + 0);
+        }
+        else {
+            ourShader.setVec2(centerLoc, glm::vec2(screenEarthX, screenEarthY));
+            ourShader.setInt(useTextureLoc, 1); // Դ Texture
+            ourShader.setMat4(transformLoc, earthTransform);
+            drawMesh(earthCircle, GL_TRIANGLES); // ǧѹ ѹ袹Ҵҧѹ
+        }
+
+
+        glm::mat4 moonTransform = glm::scale(scene.getWorld(moonNode), glm::vec3(0.1f));
         // 1. ҵ˹š NDC (-1 ֧ 1)
-        glm::vec4 moonPosNDC = moonTransform * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        glm::vec2 moonPosNDC = scene.getWorldPosition(moonNode);
         // 2. ŧ繾ԡѴ˹Ҩ (Screen Coordinates) ˹ǡѺ gl_FragCoord
         float screenMoonX = (moonPosNDC.x + 1.0f) * 0.5f * currentWidth;
         float screenMoonY = (moonPosNDC.y + 1.0f) * 0.5f * currentHeight;
-        glUniform2f(CenterLoc, screenMoonX, screenMoonY);
-        ourShader.setInt("useTexture", 2);
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(moonTransform));
-        glBindVertexArray(moonCircle.vao);
-        glDrawElements(GL_TRIANGLES, moonCircle.indexCount, GL_UNSIGNED_INT, 0);
+        if (batchedRendering) {
+            batch.add(bodyShape, moonTransform, MATERIAL_TEXTURE + 1);
+        }
+        else {
+            ourShader.setVec2(centerLoc, glm::vec2(screenMoonX, screenMoonY));
+            ourShader.setInt(useTextureLoc, 2);
+            ourShader.setMat4(transformLoc, moonTransform);
+            drawMesh(moonCircle, GL_TRIANGLES);
+        }
+
+        // extra bodies (moon texture)
+        for (int i = 0; i < asteroidCount; i++) {
+            const glm::mat4& asteroidTransform = scene.getWorld(asteroidNodes[i]);
+            if (batchedRendering) {
+                batch.add(bodyShape, asteroidTransform, MATERIAL_TEXTURE + 1);
+                continue;
+            }
+            glm::vec2 asteroidPosNDC = scene.getWorldPosition(asteroidNodes[i]);
+            float screenX = (asteroidPosNDC.x + 1.0f) * 0.5f * currentWidth;
+            float screenY = (asteroidPosNDC.y + 1.0f) * 0.5f * currentHeight;
+            ourShader.setVec2(centerLoc, glm::vec2(screenX, screenY));
+            ourShader.setInt(useTextureLoc, 2);
+            ourShader.setMat4(transformLoc, asteroidTransform);
+            drawMesh(asteroidCircle, GL_TRIANGLES);
+        }
 
 
         // --- Ҵǧ⤨š (ͺǧҷԵ) ---
-        glm::mat4 orbitTransform = glm::mat4(1.0f);
-        orbitTransform = glm::scale(orbitTransform, glm::vec3(1.0f / aspect, 1.0f, 1.0f));
-        orbitTransform = glm::translate(orbitTransform, glm::vec3(xNDC * aspect, yNDC, 0.0f));
-        ourShader.setInt("useTexture", 3); 
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(orbitTransform));
-        glBindVertexArray(earthOrbitLine.vao);
-        glDrawElements(GL_LINES, earthOrbitLine.indexCount, GL_UNSIGNED_INT, 0);
+        glm::mat4 orbitTransform = glm::scale(scene.getWorld(sunNode), glm::vec3(0.75f));
+        if (batchedRendering) {
+            batch.add(earthLineShape, orbitTransform, MATERIAL_LINE, EARTH_ORBIT_SEGMENTS / 2.0f);
+        }
+        else {
+            ourShader.setInt(useTextureLoc, 3); 
+            ourShader.setMat4(transformLoc, orbitTransform);
+            drawMesh(earthOrbitLine, GL_LINES);
+        }
 
         // --- Ҵǧ⤨ôǧѹ (ͺš) ---
-        glm::mat4 moonOrbitTransform = glm::mat4(1.0f);
-        moonOrbitTransform = glm::scale(moonOrbitTransform, glm::vec3(1.0f / aspect, 1.0f, 1.0f));
-        moonOrbitTransform = glm::translate(moonOrbitTransform, glm::vec3(earthPosNDC.x * aspect, earthPosNDC.y, 0.0f));
-        ourShader.setInt("useTexture", 3);
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(moonOrbitTransform));
-        glBindVertexArray(moonOrbitLine.vao);
-        glDrawElements(GL_LINES, moonOrbitLine.indexCount, GL_UNSIGNED_INT, 0);
+        glm::mat4 moonOrbitTransform = glm::scale(scene.getWorld(earthOrbitNode), glm::vec3(0.25f));
+        if (batchedRendering) {
+            batch.add(moonLineShape, moonOrbitTransform, MATERIAL_LINE, MOON_ORBIT_SEGMENTS / 2.0f);
+        }
+        else {
+            ourShader.setInt(useTextureLoc, 3);
+            ourShader.setMat4(transformLoc, moonOrbitTransform);
+            drawMesh(moonOrbitLine, GL_LINES);
+        }
+
+        // everything added above: one instanced draw for the bodies, one per orbit ring (one in all with sdfShapes)
+        if (batchedRendering)
+            batch.flush();
 
         glBindVertexArray(0);
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
-    // Cleanup
-    glDeleteVertexArrays(1, &sunCircle.vao);
-    glDeleteBuffers(1, &sunCircle.vbo);
-    glDeleteBuffers(1, &sunCircle.ebo);
-
-    glDeleteVertexArrays(1, &earthCircle.vao);
-    glDeleteBuffers(1, &earthCircle.vbo);
-    glDeleteBuffers(1, &earthCircle.ebo);
-
-    glDeleteVertexArrays(1, &moonCircle.vao);
-    glDeleteBuffers(1, &moonCircle.vbo);
-    glDeleteBuffers(1, &moonCircle.ebo);
-
-    glDeleteVertexArrays(1, &earthOrbitLine.vao);
-    glDeleteBuffers(1, &earthOrbitLine.vbo);
-    glDeleteBuffers(1, &earthOrbitLine.ebo);
-
-    glDeleteVertexArrays(1, &moonOrbitLine.vao);
-    glDeleteBuffers(1, &moonOrbitLine.vbo);
-    glDeleteBuffers(1, &moonOrbitLine.ebo);
+    // Cleanup: the last reference of each shared mesh deletes its buffers
+    if (!batchedRendering) {
+        meshes.release(sunCircle);
+        meshes.release(earthCircle);
+        meshes.release(moonCircle);
+        meshes.release(earthOrbitLine);
+        meshes.release(moonOrbitLine);
+        meshes.release(asteroidCircle);
+        glDeleteTextures(1, &texture1);
+        glDeleteTextures(1, &texture2);
+    }
+    else {
+        batch.release();
+        glDeleteTextures(1, &textureArray);
+    }
+    batchShader.release();
+    frameUBO.release();
+    ourShader.release();
 
     glfwTerminate();
     return 0;
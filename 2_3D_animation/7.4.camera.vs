@@ -1,15 +1,28 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
+layout (location = 3) in vec3 aOffset;   // per-instance position (instanced mode), (0,0,0) otherwise
 
 out vec2 TexCoord;
+out vec3 worldPos;             // displaced world position, captured by the --parity check (transform feedback)
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+#include "7.4.camera_common.glsl"
+
+uniform bool gpuWaves;         // displace on the GPU; positions from the CPU are the undisplaced grid
+uniform bool perVertexWaves;   // lines: every vertex is a grid point, spheres: displace the whole instance
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0f);
+	vec3 displacement = vec3(0.0f);
+	if (gpuWaves)
+	{
+		vec3 anchor = model[3].xyz + aOffset + (perVertexWaves ? aPos : vec3(0.0f));
+		displacement = gerstner(anchor.xz);
+	}
+	vec4 world = model * vec4(aPos, 1.0f) + vec4(aOffset + displacement, 0.0f);
+	gl_Position = projection * view * world;
+	worldPos = world.xyz;
 	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
-}
\ No newline at end of file
+}
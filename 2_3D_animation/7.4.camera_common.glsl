@@ -0,0 +1,34 @@
+// shared by the 7.4.camera* stages, pulled in with #include "7.4.camera_common.glsl"
+// (expanded by CachedShader); one definition of the blocks and the wave model
+
+// per-frame data, one buffer write per frame (must match FrameUniforms in camera_class.cpp)
+layout (std140) uniform Frame
+{
+	mat4 projection;
+	mat4 view;
+	float time;
+};
+
+// GPU Gerstner waves (must match WaveBlock in WaveSet.h)
+#define MAX_WAVES 8
+struct Wave
+{
+	vec4 phase;       // xy: k * direction, z: k * c
+	vec4 amplitude;   // xy: a * direction, z: a
+};
+layout (std140) uniform Waves
+{
+	Wave waves[MAX_WAVES];
+	int waveCount;
+};
+
+vec3 gerstner(vec2 p)
+{
+	vec3 offset = vec3(0.0f);
+	for (int i = 0; i < waveCount; ++i)
+	{
+		float f = dot(waves[i].phase.xy, p) - waves[i].phase.z * time;
+		offset += vec3(waves[i].amplitude.x * cos(f), waves[i].amplitude.z * sin(f), waves[i].amplitude.y * cos(f));
+	}
+	return offset;
+}
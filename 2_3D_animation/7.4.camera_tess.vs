@@ -0,0 +1,22 @@
+#version 400 core
+layout (location = 0) in vec3 aPos;      // icosahedron corner, unit radius
+layout (location = 3) in vec3 aOffset;   // per-instance position (instanced mode), (0,0,0) otherwise
+
+out vec3 vPos;
+out vec3 vCenter;                        // world position of the sphere center
+
+uniform mat4 model;
+
+#include "7.4.camera_common.glsl"
+
+uniform bool gpuWaves;         // displace on the GPU; positions from the CPU are the undisplaced grid
+
+void main()
+{
+	// the whole sphere moves with the wave at its center
+	vec3 center = model[3].xyz + aOffset;
+	if (gpuWaves)
+		center += gerstner(center.xz);
+	vPos = aPos;
+	vCenter = center;
+}
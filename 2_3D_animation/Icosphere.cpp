@@ -10,24 +10,29 @@
 // UPDATED: 2024-09-05
 ///////////////////////////////////////////////////////////////////////////////
 
-#ifdef _WIN32
-#include <windows.h>    // include windows.h to avoid thousands of compile errors even though this class is not depending on Windows
-#endif
-
-#ifdef __APPLE__
-#include <OpenGL/gl.h>
-#else
-#include <GL/gl.h>
-#endif
-
+#include <glad/glad.h>
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <cstring>
+#include <algorithm>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ICOSPHERE_SSE
+#include <xmmintrin.h>
+#endif
 #include "Icosphere.h"
+#include "IcosphereBuffers.h"
+#include "JobSystem.h"
 
 
 
 // constants //////////////////////////////////////////////////////////////////
+//const float S_STEP = 1 / 11.0f;         // horizontal texture step
+//const float T_STEP = 1 / 3.0f;          // vertical texture step
+const float S_STEP = 186 / 2048.0f;     // horizontal texture step
+const float T_STEP = 322 / 1024.0f;     // vertical texture step
+const int MIN_PARALLEL_SUBDIVISION = 16;  // below this, the faces are built on the calling thread
+const int EDGE_ENDS[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };   // 3 edges of a triangle (v1-v2, v1-v3, v2-v3)
 
 
 
@@ -35,7 +40,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 // ctor
 ///////////////////////////////////////////////////////////////////////////////
-Icosphere::Icosphere(float radius, int sub, bool smooth) : radius(radius), subdivision(sub), smooth(smooth), interleavedStride(32)
+Icosphere::Icosphere(float radius, int sub, bool smooth, VertexFormat format, JobSystem* jobs) : radius(radius), subdivision(sub),
+                                                                                 smooth(smooth), normalsReversed(false), jobs(jobs), vertexFormat(format), interleavedStride(32),
+                                                                                 buffersDirty(true), positionsDirty(false)
 {
     if (smooth)
         buildVerticesSmooth();
@@ -45,6 +52,17 @@ Icosphere::Icosphere(float radius, int sub, bool smooth) : radius(radius), subdi
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// dtor
+// the GL objects are not deleted here (the context may be gone already), call
+// releaseBuffers() while the context is current
+///////////////////////////////////////////////////////////////////////////////
+Icosphere::~Icosphere()
+{
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // setters
 ///////////////////////////////////////////////////////////////////////////////
@@ -76,6 +94,18 @@ void Icosphere::setSmooth(bool smooth)
         buildVerticesFlat();
 }
 
+void Icosphere::setVertexFormat(VertexFormat format)
+{
+    if (this->vertexFormat == format)
+        return;
+
+    this->vertexFormat = format;
+    if (smooth)
+        buildInterleavedVertices();
+    else
+        rebuildVerticesFlat();      // no separate arrays to convert from
+}
+
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -83,19 +113,40 @@ void Icosphere::setSmooth(bool smooth)
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::reverseNormals()
 {
-    std::size_t i, j;
+    std::size_t i;
     std::size_t count = normals.size();
-    for (i = 0, j = 3; i < count; i += 3, j += 8)
-    {
+    for (i = 0; i < count; ++i)
         normals[i] *= -1;
-        normals[i + 1] *= -1;
-        normals[i + 2] *= -1;
 
+    if (smooth)
+    {
         // update interleaved array
-        interleavedVertices[j] = normals[i];
-        interleavedVertices[j + 1] = normals[i + 1];
-        interleavedVertices[j + 2] = normals[i + 2];
+        buildInterleavedVertices();
+    }
+    else
+    {
+        // flat: the interleaved array is the only copy, flip its normals in place
+        // (negating the 10-bit fields gives the same bits as packing -n)
+        count = getVertexCount();
+        unsigned char* out = interleavedVertices.data();
+        for (i = 0; i < count; ++i, out += interleavedStride)
+        {
+            if (vertexFormat == VERTEX_FORMAT_PACKED)
+            {
+                unsigned int packed, flipped = 0;
+                std::memcpy(&packed, out + 8, 4);
+                for (int j = 0; j < 3; ++j)
+                    flipped |= ((0u - ((packed >> (j * 10)) & 0x3ff)) & 0x3ff) << (j * 10);
+                std::memcpy(out + 8, &flipped, 4);
+            }
+            else
+            {
+                float* n = (float*)(out + 12);
+                n[0] = -n[0];   n[1] = -n[1];   n[2] = -n[2];
+            }
+        }
     }
+    normalsReversed = !normalsReversed;
 
     // also reverse triangle windings
     unsigned int tmp;
@@ -106,6 +157,7 @@ void Icosphere::reverseNormals()
         indices[i] = indices[i + 2];
         indices[i + 2] = tmp;
     }
+    buffersDirty = true;
 }
 
 
@@ -122,57 +174,73 @@ void Icosphere::printSelf() const
         << "    Smoothness: " << (smooth ? "true" : "false") << "\n"
         << "Triangle Count: " << getTriangleCount() << "\n"
         << "   Index Count: " << getIndexCount() << "\n"
-        << "  Vertex Count: " << getVertexCount() << "\n"
+        << "  Vertex Count: " << getVertexCount() << (smooth ? "" : " (interleaved only)") << "\n"
         << "  Normal Count: " << getNormalCount() << "\n"
-        << "TexCoord Count: " << getTexCoordCount() << std::endl;
+        << "TexCoord Count: " << getTexCoordCount() << "\n"
+        << "    Cache ACMR: " << getAcmr(32) << "\n"
+        << "    Cache ATVR: " << getAtvr(32) << std::endl;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// draw a icosphere in VertexArray mode
+// GPU buffers of the sphere, created on the first use and uploaded again only
+// after the vertices or indices have changed (after setRadius(), only the
+// VBO, in full)
 // OpenGL RC must be set before calling it
 ///////////////////////////////////////////////////////////////////////////////
-void Icosphere::draw() const
+const IcosphereBuffers& Icosphere::getBuffers() const
+{
+    if (!buffers)
+        buffers.reset(new IcosphereBuffers());
+
+    if (buffersDirty || !buffers->isCreated())
+    {
+        buffers->create(interleavedVertices.data(), interleavedVertices.size(), interleavedStride, interleavedAttribs,
+                        indices.data(), indices.size(), lineIndices.data(), lineIndices.size());
+        buffersDirty = false;
+        positionsDirty = false;
+    }
+    else if (positionsDirty)
+    {
+        buffers->updateVertices(0, interleavedVertices.size(), interleavedVertices.data());
+        positionsDirty = false;
+    }
+    return *buffers;
+}
+
+void Icosphere::releaseBuffers()
 {
-    // interleaved array
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_NORMAL_ARRAY);
-    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-    glVertexPointer(3, GL_FLOAT, interleavedStride, &interleavedVertices[0]);
-    glNormalPointer(GL_FLOAT, interleavedStride, &interleavedVertices[3]);
-    glTexCoordPointer(2, GL_FLOAT, interleavedStride, &interleavedVertices[6]);
-
-    glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, indices.data());
-
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glDisableClientState(GL_NORMAL_ARRAY);
-    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    if (buffers)
+        buffers->release();
+    buffersDirty = true;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// draw lines only
-// the caller must set the line width before call this
+// draw a icosphere from the buffer objects
+// OpenGL RC and a shader reading attrib 0/1/2 must be set before calling it
 ///////////////////////////////////////////////////////////////////////////////
-void Icosphere::drawLines(const float lineColor[4]) const
+void Icosphere::draw() const
 {
-    // set line colour
-    glColor4fv(lineColor);
-    glMaterialfv(GL_FRONT, GL_DIFFUSE, lineColor);
+    getBuffers().draw();
+}
+
+void Icosphere::drawInstanced(int instanceCount) const
+{
+    getBuffers().draw(instanceCount);
+}
 
-    // draw lines with VA
-    glDisable(GL_LIGHTING);
-    glDisable(GL_TEXTURE_2D);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(3, GL_FLOAT, 0, vertices.data());
 
-    glDrawElements(GL_LINES, (unsigned int)lineIndices.size(), GL_UNSIGNED_INT, lineIndices.data());
 
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glEnable(GL_LIGHTING);
-    glEnable(GL_TEXTURE_2D);
+///////////////////////////////////////////////////////////////////////////////
+// draw lines only
+// the caller must set the line width and colour (shader uniform) before call this
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::drawLines() const
+{
+    getBuffers().drawLines();
 }
 
 
@@ -181,39 +249,94 @@ void Icosphere::drawLines(const float lineColor[4]) const
 // draw a icosphere surfaces and lines on top of it
 // the caller must set the line width before call this
 ///////////////////////////////////////////////////////////////////////////////
-void Icosphere::drawWithLines(const float lineColor[4]) const
+void Icosphere::drawWithLines() const
 {
     glEnable(GL_POLYGON_OFFSET_FILL);
     glPolygonOffset(1.0, 1.0f); // move polygon backward
     this->draw();
     glDisable(GL_POLYGON_OFFSET_FILL);
 
-    // draw lines with VA
-    drawLines(lineColor);
+    // lines from the same VAO
+    drawLines();
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // update vertex positions only
+// All vertices are on the sphere, so one scale factor fits all of them. The
+// position fields of the interleaved array are patched in place (normals and
+// texcoords are untouched). Every vertex moves, so the whole VBO is stale: the
+// next getBuffers() re-uploads it with one glBufferSubData() into the existing
+// buffer, which skips the index buffers and the VAO setup but not the bytes.
+// For animated or per-instance sizes, prefer a unit sphere scaled by the model
+// matrix: no upload at all.
+// A flat sphere has the interleaved array only: the float positions are scaled
+// there, the half float ones are rebuilt instead (re-rounding them on every
+// call would drift).
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::updateRadius()
 {
-    float scale = computeScaleForLength(&vertices[0], radius);
+    std::size_t count = getVertexCount();
+    if (count == 0)
+        return;
+
+    float scale;
+    std::size_t i = 0;
+    float* v = vertices.data();
+    if (smooth)
+    {
+        scale = computeScaleForLength(&vertices[0], radius);
+        std::size_t floatCount = count * 3;
+#ifdef ICOSPHERE_SSE
+        __m128 scale4 = _mm_set1_ps(scale);
+        for (; i + 4 <= floatCount; i += 4)
+            _mm_storeu_ps(v + i, _mm_mul_ps(_mm_loadu_ps(v + i), scale4));
+#endif
+        for (; i < floatCount; ++i)
+            v[i] *= scale;
+    }
+    else if (vertexFormat == VERTEX_FORMAT_PACKED)
+    {
+        rebuildVerticesFlat();
+        return;
+    }
+    else
+    {
+        float position[3];
+        std::memcpy(position, interleavedVertices.data(), 12);
+        scale = computeScaleForLength(position, radius);
+    }
 
-    std::size_t i, j;
-    std::size_t count = vertices.size();
-    for (i = 0, j = 0; i < count; i += 3, j += 8)
+    unsigned char* out = interleavedVertices.data();
+    if (vertexFormat == VERTEX_FORMAT_PACKED)
     {
-        vertices[i] *= scale;
-        vertices[i + 1] *= scale;
-        vertices[i + 2] *= scale;
-
-        // for interleaved array
-        interleavedVertices[j] *= scale;
-        interleavedVertices[j + 1] *= scale;
-        interleavedVertices[j + 2] *= scale;
+        for (i = 0; i < count; ++i, out += interleavedStride)
+        {
+            unsigned short position[3] = { toHalfFloat(v[i * 3]), toHalfFloat(v[i * 3 + 1]), toHalfFloat(v[i * 3 + 2]) };
+            std::memcpy(out, position, 6);
+        }
     }
+    else
+    {
+        // x, y, z and the normal x that follows as 4 floats, the 4th scaled by 1
+#ifdef ICOSPHERE_SSE
+        __m128 scaleXyz = _mm_setr_ps(scale, scale, scale, 1.0f);
+        for (i = 0; i < count; ++i, out += interleavedStride)
+        {
+            float* p = (float*)out;
+            _mm_storeu_ps(p, _mm_mul_ps(_mm_loadu_ps(p), scaleXyz));
+        }
+#else
+        for (i = 0; i < count; ++i, out += interleavedStride)
+        {
+            float* p = (float*)out;
+            p[0] *= scale;  p[1] *= scale;  p[2] *= scale;
+        }
+#endif
+    }
+
+    positionsDirty = true;
 }
 
 
@@ -224,7 +347,7 @@ void Icosphere::updateRadius()
 // 5 vertices are placed by rotating 72 deg at elevation 26.57 deg (=atan(1/2))
 // 5 vertices are placed by rotating 72 deg at elevation -26.57 deg
 ///////////////////////////////////////////////////////////////////////////////
-std::vector<float> Icosphere::computeIcosahedronVertices()
+std::vector<float> Icosphere::computeIcosahedronVertices() const
 {
     const float PI = acos(-1.0f);
     const float H_ANGLE = PI / 180 * 72;    // 72 degree = 360 / 5
@@ -276,14 +399,12 @@ std::vector<float> Icosphere::computeIcosahedronVertices()
 ///////////////////////////////////////////////////////////////////////////////
 // generate vertices with flat shading
 // each triangle is independent (no shared vertices)
+// The 20 triangles of icosahedron are built in the separate arrays, then
+// subdivided straight into the interleaved array, the separate arrays are not
+// kept.
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::buildVerticesFlat()
 {
-    //const float S_STEP = 1 / 11.0f;         // horizontal texture step
-    //const float T_STEP = 1 / 3.0f;          // vertical texture step
-    const float S_STEP = 186 / 2048.0f;     // horizontal texture step
-    const float T_STEP = 322 / 1024.0f;     // vertical texture step
-
     // compute 12 vertices of icosahedron
     std::vector<float> tmpVertices = computeIcosahedronVertices();
 
@@ -293,6 +414,8 @@ void Icosphere::buildVerticesFlat()
     std::vector<float>().swap(texCoords);
     std::vector<unsigned int>().swap(indices);
     std::vector<unsigned int>().swap(lineIndices);
+    std::vector<unsigned char>().swap(interleavedVertices);
+    normalsReversed = false;
 
     const float* v0, * v1, * v2, * v3, * v4, * v11;          // vertex positions
     float n[3];                                         // face normal
@@ -371,11 +494,24 @@ void Icosphere::buildVerticesFlat()
         index += 12;
     }
 
-    // subdivide icosahedron
+    // subdivide icosahedron into the interleaved array
     subdivideVerticesFlat();
+}
 
-    // generate interleaved vertex array as well
-    buildInterleavedVertices();
+
+
+///////////////////////////////////////////////////////////////////////////////
+// rebuild a flat sphere at the current radius and vertex format, for the
+// changes that need the float data the interleaved array does not keep
+// (the closed-form build costs about the same as converting every vertex)
+// The triangle order is not affected, a flat sphere has nothing to optimize.
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::rebuildVerticesFlat()
+{
+    bool reversed = normalsReversed;
+    buildVerticesFlat();
+    if (reversed)
+        reverseNormals();
 }
 
 
@@ -388,11 +524,6 @@ void Icosphere::buildVerticesFlat()
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::buildVerticesSmooth()
 {
-    //const float S_STEP = 1 / 11.0f;         // horizontal texture step
-    //const float T_STEP = 1 / 3.0f;          // vertical texture step
-    const float S_STEP = 186 / 2048.0f;     // horizontal texture step
-    const float T_STEP = 322 / 1024.0f;     // vertical texture step
-
     // compute 12 vertices of icosahedron
     // NOTE: v0 (top), v11(bottom), v1, v6(first vert on each row) cannot be
     // shared for smooth shading (they have different texcoords)
@@ -404,7 +535,7 @@ void Icosphere::buildVerticesSmooth()
     std::vector<float>().swap(texCoords);
     std::vector<unsigned int>().swap(indices);
     std::vector<unsigned int>().swap(lineIndices);
-    std::map<std::pair<float, float>, unsigned int>().swap(sharedIndices);
+    normalsReversed = false;
 
     float v[3];                             // vertex
     float n[3];                             // normal
@@ -489,14 +620,12 @@ void Icosphere::buildVerticesSmooth()
     vertices.insert(vertices.end(), v, v + 3);
     normals.insert(normals.end(), n, n + 3);
     texCoords.insert(texCoords.end(), { S_STEP * 2, T_STEP });
-    sharedIndices[std::make_pair(S_STEP * 2, T_STEP)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[9];  v[1] = tmpVertices[10]; v[2] = tmpVertices[11]; // v15 (shared)
     Icosphere::computeVertexNormal(v, n);
     vertices.insert(vertices.end(), v, v + 3);
     normals.insert(normals.end(), n, n + 3);
     texCoords.insert(texCoords.end(), { S_STEP * 4, T_STEP });
-    sharedIndices[std::make_pair(S_STEP * 4, T_STEP)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[12]; v[1] = tmpVertices[13]; v[2] = tmpVertices[14]; // v16 (shared)
     scale = Icosphere::computeScaleForLength(v, 1);
@@ -504,42 +633,36 @@ void Icosphere::buildVerticesSmooth()
     vertices.insert(vertices.end(), v, v + 3);
     normals.insert(normals.end(), n, n + 3);
     texCoords.insert(texCoords.end(), { S_STEP * 6, T_STEP });
-    sharedIndices[std::make_pair(S_STEP * 6, T_STEP)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[15]; v[1] = tmpVertices[16]; v[2] = tmpVertices[17]; // v17 (shared)
     Icosphere::computeVertexNormal(v, n);
     vertices.insert(vertices.end(), v, v + 3);
     normals.insert(normals.end(), n, n + 3);
     texCoords.insert(texCoords.end(), { S_STEP * 8, T_STEP });
-    sharedIndices[std::make_pair(S_STEP * 8, T_STEP)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[21]; v[1] = tmpVertices[22]; v[2] = tmpVertices[23]; // v18 (shared)
     Icosphere::computeVertexNormal(v, n);
     vertices.insert(vertices.end(), v, v + 3);
     normals.insert(normals.end(), n, n + 3);
     texCoords.insert(texCoords.end(), { S_STEP * 3, T_STEP * 2 });
-    sharedIndices[std::make_pair(S_STEP * 3, T_STEP * 2)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[24]; v[1] = tmpVertices[25]; v[2] = tmpVertices[26]; // v19 (shared)
     Icosphere::computeVertexNormal(v, n);
     vertices.insert(vertices.end(), v, v + 3);
     normals.insert(normals.end(), n, n + 3);
     texCoords.insert(texCoords.end(), { S_STEP * 5, T_STEP * 2 });
-    sharedIndices[std::make_pair(S_STEP * 5, T_STEP * 2)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[27]; v[1] = tmpVertices[28]; v[2] = tmpVertices[29]; // v20 (shared)
     Icosphere::computeVertexNormal(v, n);
     vertices.insert(vertices.end(), v, v + 3);
     normals.insert(normals.end(), n, n + 3);
     texCoords.insert(texCoords.end(), { S_STEP * 7, T_STEP * 2 });
-    sharedIndices[std::make_pair(S_STEP * 7, T_STEP * 2)] = texCoords.size() / 2 - 1;
 
     v[0] = tmpVertices[30]; v[1] = tmpVertices[31]; v[2] = tmpVertices[32]; // v21 (shared)
     Icosphere::computeVertexNormal(v, n);
     vertices.insert(vertices.end(), v, v + 3);
     normals.insert(normals.end(), n, n + 3);
     texCoords.insert(texCoords.end(), { S_STEP * 9, T_STEP * 2 });
-    sharedIndices[std::make_pair(S_STEP * 9, T_STEP * 2)] = texCoords.size() / 2 - 1;
 
     // build index list for icosahedron (20 triangles)
     addIndices(0, 10, 14);      // 1st row (5 tris)
@@ -614,152 +737,153 @@ void Icosphere::buildVerticesSmooth()
 //   S   S - S
 //  / \ / \ / \   .
 // O - S - S - O
+//
+// Each triangle of icosahedron is split into N^2 sub-triangles with their own
+// 3 vertices, so every face owns a disjoint range of the output arrays:
+//      # of vertices       = 20 * 3N^2
+//      # of indices        = 20 * 3N^2
+//      # of line indices   = 20 * 4N^2
+// The arrays are sized once, then the faces are filled in parallel. The
+// vertices go straight into the interleaved array in the final format: no
+// separate V/N/T arrays to fill and interleave afterwards, which was most of
+// the time (and twice the memory) of a flat build.
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::subdivideVerticesFlat()
 {
+    // move prev arrays out (20 triangles of icosahedron), a flat sphere keeps the interleaved array only
+    std::vector<float> tmpVertices, tmpNormals, tmpTexCoords;
+    tmpVertices.swap(vertices);
+    tmpNormals.swap(normals);
+    tmpTexCoords.swap(texCoords);
+    std::vector<unsigned int> tmpIndices = indices;
+    int faceCount = (int)tmpIndices.size() / 3;
+
+    setInterleavedLayout();
     if (subdivision <= 1)
+    {
+        // icosahedron as is
+        std::size_t count = tmpVertices.size() / 3;
+        interleavedVertices.resize(count * interleavedStride);
+        for (std::size_t i = 0; i < count; ++i)
+            writeInterleavedVertex(&tmpVertices[i * 3], &tmpNormals[i * 3], &tmpTexCoords[i * 2],
+                                   &interleavedVertices[i * interleavedStride]);
         return;
+    }
+
+    // presize the arrays with the closed-form counts
+    std::size_t faceVertexCount = 3 * (std::size_t)subdivision * subdivision;
+    interleavedVertices.resize(faceCount * faceVertexCount * interleavedStride);
+    indices.resize(faceCount * faceVertexCount);
+    lineIndices.resize(faceCount * 4 * (std::size_t)subdivision * subdivision);
 
-    unsigned int subVertexCount = (subdivision + 1) * (subdivision + 2) / 2;
-    std::vector<float> newVs(subVertexCount * 3);
-    std::vector<float> newNs(subVertexCount * 3);
-    std::vector<float> newTs(subVertexCount * 2);
-
-    std::vector<float> tmpVertices;
-    std::vector<float> tmpTexCoords;
-    std::vector<unsigned int> tmpIndices;
-    const float* v1, * v2, * v3;          // ptr to original vertices of a triangle
-    const float* t1, * t2, * t3;          // ptr to original texcoords of a triangle
-    float newV1[3], newV2[3], newV3[3]; // new vertex positions
-    float newT1[2], newT2[2], newT3[2]; // new texture coords
-    float normal[3];                    // new face normal
-    int i, j, k;
-    float a;                            // lerp alpha
-    unsigned int index = 0;             // new index value
-    unsigned int i1, i2;                // indices
-
-    // copy prev arrays
-    tmpVertices = vertices;
-    tmpTexCoords = texCoords;
-    tmpIndices = indices;
-
-    // clear prev arrays
-    vertices.clear();
-    normals.clear();
-    texCoords.clear();
-    indices.clear();
-    lineIndices.clear();
-
-    int indexCount = (int)tmpIndices.size();
-    for (i = 0; i < indexCount; i += 3)
+    runPerFace(faceCount, [&](int faceBegin, int faceEnd)
     {
-        // get 3 vertice and texcoords of a triangle of icosahedron
-        v1 = &tmpVertices[tmpIndices[i] * 3];
-        v2 = &tmpVertices[tmpIndices[i + 1] * 3];
-        v3 = &tmpVertices[tmpIndices[i + 2] * 3];
-        t1 = &tmpTexCoords[tmpIndices[i] * 2];
-        t2 = &tmpTexCoords[tmpIndices[i + 1] * 2];
-        t3 = &tmpTexCoords[tmpIndices[i + 2] * 2];
-
-        // add top vertex and textcoord (x,y,z), (s,t)
-        newVs.clear();
-        newTs.clear();
-        newVs.insert(newVs.end(), v1, v1 + 3);
-        newTs.insert(newTs.end(), t1, t1 + 2);
-
-        // find new vertices by subdividing edges
-        for (j = 1; j <= subdivision; ++j)
+        // 2 rows of sub-vertices (x,y,z,s,t), allocated once per worker
+        std::vector<float> rows((subdivision + 1) * 5 * 2);
+        for (int face = faceBegin; face < faceEnd; ++face)
+            subdivideFaceFlat(face, tmpVertices.data(), tmpTexCoords.data(), tmpIndices.data(), rows.data());
+    });
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// subdivide a triangle of icosahedron for flat shading, row by row, into the
+// interleaved array
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::subdivideFaceFlat(int face, const float* baseVertices, const float* baseTexCoords,
+                                  const unsigned int* baseIndices, float* rows)
+{
+    // get 3 vertice and texcoords of a triangle of icosahedron
+    const float* v1 = &baseVertices[baseIndices[face * 3] * 3];
+    const float* v2 = &baseVertices[baseIndices[face * 3 + 1] * 3];
+    const float* v3 = &baseVertices[baseIndices[face * 3 + 2] * 3];
+    const float* t1 = &baseTexCoords[baseIndices[face * 3] * 2];
+    const float* t2 = &baseTexCoords[baseIndices[face * 3 + 1] * 2];
+    const float* t3 = &baseTexCoords[baseIndices[face * 3 + 2] * 2];
+
+    // output ranges of this face
+    std::size_t faceVertexCount = 3 * (std::size_t)subdivision * subdivision;
+    unsigned int index = (unsigned int)(face * faceVertexCount);
+    unsigned char* vertexOut = &interleavedVertices[index * (std::size_t)interleavedStride];
+    unsigned int* indexOut = &indices[index];
+    unsigned int* lineOut = &lineIndices[face * 4 * (std::size_t)subdivision * subdivision];
+
+    // prev/curr row of sub-vertices, 5 floats each (x,y,z,s,t)
+    float* prevRow = rows;
+    float* currRow = rows + (subdivision + 1) * 5;
+    prevRow[0] = v1[0]; prevRow[1] = v1[1]; prevRow[2] = v1[2];
+    prevRow[3] = t1[0]; prevRow[4] = t1[1];
+
+    float newV1[3], newV2[3];           // end vertices of the current row
+    float newT1[2], newT2[2];
+    float normal[3];
+    for (int j = 1; j <= subdivision; ++j)
+    {
+        // find 2 end vertices on the edges of the current row
+        //          v1           //
+        //         / \           // if N = 3,
+        //        *---*          // lerp alpha = 1 / N
+        //       / \ / \         //
+        // newV1*---*---* newV2  // lerp alpha = 2 / N
+        //     / \newV3/ \       //
+        //    v2--*---*---v3     //
+        float a = (float)j / subdivision;
+        Icosphere::interpolateVertex(v1, v2, a, radius, newV1);
+        Icosphere::interpolateVertex(v1, v3, a, radius, newV2);
+        Icosphere::interpolateTexCoord(t1, t2, a, newT1);
+        Icosphere::interpolateTexCoord(t1, t3, a, newT2);
+        for (int k = 0; k <= j; ++k)
         {
-            a = (float)j / subdivision;    // lerp alpha
-
-            // find 2 end vertices on the edges of the current row
-            //          v1           //
-            //         / \           // if N = 3,
-            //        *---*          // lerp alpha = 1 / N
-            //       / \ / \         //
-            // newV1*---*---* newV2  // lerp alpha = 2 / N
-            //     / \newV3/ \       //
-            //    v2--*---*---v3     //
-            Icosphere::interpolateVertex(v1, v2, a, radius, newV1);
-            Icosphere::interpolateVertex(v1, v3, a, radius, newV2);
-            Icosphere::interpolateTexCoord(t1, t2, a, newT1);
-            Icosphere::interpolateTexCoord(t1, t3, a, newT2);
-            for (k = 0; k <= j; ++k)
+            float* p = &currRow[k * 5];
+            if (k == 0)      // new vertex on the left edge, newV1
+            {
+                p[0] = newV1[0]; p[1] = newV1[1]; p[2] = newV1[2];
+                p[3] = newT1[0]; p[4] = newT1[1];
+            }
+            else if (k == j) // new vertex on the right edge, newV2
             {
-                if (k == 0)      // new vertex on the left edge, newV1
-                {
-                    newVs.insert(newVs.end(), newV1, newV1 + 3);
-                    newTs.insert(newTs.end(), newT1, newT1 + 2);
-                }
-                else if (k == j) // new vertex on the right edge, newV2
-                {
-                    newVs.insert(newVs.end(), newV2, newV2 + 3);
-                    newTs.insert(newTs.end(), newT2, newT2 + 2);
-                }
-                else            // new vertices between newV1 and newV2
-                {
-                    a = (float)k / j;
-                    Icosphere::interpolateVertex(newV1, newV2, a, radius, newV3);
-                    Icosphere::interpolateTexCoord(newT1, newT2, a, newT3);
-                    newVs.insert(newVs.end(), newV3, newV3 + 3);
-                    newTs.insert(newTs.end(), newT3, newT3 + 2);
-                }
+                p[0] = newV2[0]; p[1] = newV2[1]; p[2] = newV2[2];
+                p[3] = newT2[0]; p[4] = newT2[1];
+            }
+            else            // new vertices between newV1 and newV2
+            {
+                a = (float)k / j;
+                Icosphere::interpolateVertex(newV1, newV2, a, radius, p);
+                Icosphere::interpolateTexCoord(newT1, newT2, a, p + 3);
             }
         }
 
-        // compute sub-triangles from new vertices
+        // compute sub-triangles between the prev and curr rows
         //      /           //
         //   V1*---*-       // prev row
         //    / \ /         //
         // V2*---*V3-       // curr row
         //  /               //
-        for (j = 1; j <= subdivision; ++j)
+        for (int k = 0; k < j; ++k)
         {
-            for (k = 0; k < j; ++k)
+            const float* corners[4] = { &prevRow[k * 5], &currRow[k * 5], &currRow[(k + 1) * 5], &prevRow[(k + 1) * 5] };
+            int triangleCount = (k < j - 1) ? 2 : 1;    // if K is not the last, add adjacent triangle
+            for (int tri = 0; tri < triangleCount; ++tri)
             {
-                // indices
-                i1 = (j - 1) * j / 2 + k;   // index from prev row
-                i2 = j * (j + 1) / 2 + k;   // index from curr row
-
-                v1 = &newVs[i1 * 3];
-                v2 = &newVs[i2 * 3];
-                v3 = &newVs[(i2 + 1) * 3];
-                addVertices(v1, v2, v3);
-
-                Icosphere::computeFaceNormal(v1, v2, v3, normal);
-                addNormals(normal, normal, normal);
-
-                t1 = &newTs[i1 * 2];
-                t2 = &newTs[i2 * 2];
-                t3 = &newTs[(i2 + 1) * 2];
-                addTexCoords(t1, t2, t3);
-
-                // add indices
-                addIndices(index, index + 1, index + 2);
-
-                // add indices for edge lines
-                addLineIndices(index, index + 1);
-                addLineIndices(index + 1, index + 2);
-
-                index += 3; // next index
-
-                // if K is not the last, add adjacent triangle
-                if (k < (j - 1))
-                {
-                    i2 = i1 + 1; // next of the prev row
-                    v2 = &newVs[i2 * 3];
-                    addVertices(v1, v3, v2);
-                    Icosphere::computeFaceNormal(v1, v3, v2, normal);
-                    addNormals(normal, normal, normal);
-                    t2 = &newTs[i2 * 2];
-                    addTexCoords(t1, t3, t2);
-                    addIndices(index, index + 1, index + 2);
-                    addLineIndices(index, index + 1);
-                    addLineIndices(index, index + 2);
-                    index += 3;
-                }
+                // V1-V2-V3, then V1-V3-V4 for the adjacent triangle
+                const float* c1 = corners[0];
+                const float* c2 = corners[tri + 1];
+                const float* c3 = corners[tri + 2];
+                Icosphere::computeFaceNormal(c1, c2, c3, normal);
+                const float* cs[3] = { c1, c2, c3 };
+                for (int c = 0; c < 3; ++c, vertexOut += interleavedStride)
+                    writeInterleavedVertex(cs[c], normal, cs[c] + 3, vertexOut);
+
+                *indexOut++ = index; *indexOut++ = index + 1; *indexOut++ = index + 2;
+
+                // edge lines: V1-V2, V2-V3 for the first triangle, V1-V3, V1-V4 for the adjacent one
+                *lineOut++ = index; *lineOut++ = index + 1;
+                *lineOut++ = (tri == 0) ? index + 1 : index; *lineOut++ = index + 2;
+                index += 3;
             }
         }
+        std::swap(prevRow, currRow);
     }
 }
 
@@ -776,128 +900,192 @@ void Icosphere::subdivideVerticesFlat()
 //   S   S - S    //
 //  / \ / \ / \   //
 // O - S - S - O  //
+//
+// The vertex array has a closed-form layout, so every index is known without
+// looking anything up, and the 20 faces can be built in parallel:
+//  [22 vertices of icosahedron]
+//  [41 edge slots * (N-1) vertices]    edges of icosahedron; an edge shared by
+//                                      2 faces has the same 2 base indices on
+//                                      both (19 edges), an edge on a texture
+//                                      seam has different ones (11 edges, 22
+//                                      slots)
+//  [20 faces * (N-1)(N-2)/2 vertices]  inside of each face
+// An edge slot is written by the first face using it; the others only
+// reference its indices. # of indices = 60N^2, # of line indices = 80N^2
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::subdivideVerticesSmooth()
 {
     if (subdivision < 2)
         return;
 
-    std::vector<float> tmpVertices, tmpTexCoords;
-    std::vector<unsigned int> tmpIndices;
-    unsigned int i1, i2, i3, i4;        // indices of triangle
-    float a;                            // lerp alpha
-    int i, j, k;
-    // original vertex attribs from icosahedron
-    const float* icoV1, * icoV2, * icoV3;
-    const float* icoT1, * icoT2, * icoT3;
-    unsigned int icoI1, icoI2, icoI3;
-    std::vector<unsigned int> prevIs;   // indices of prev row
-    std::vector<unsigned int> currIs;   // indices of curr row
-    // vertex attribs on left/right edges
-    float edgeV1[3], edgeV2[3], edgeN1[3], edgeN2[3], edgeT1[2], edgeT2[2];
-    unsigned int edgeI1, edgeI2;
-
-    // copy prev indices
-    tmpIndices = indices;
-    tmpVertices = vertices;
-    tmpTexCoords = texCoords;
-
-    // clear prev arrays
-    indices.clear();
-    lineIndices.clear();
-
-    int indexCount = (int)tmpIndices.size();
-    for (i = 0; i < indexCount; i += 3)
+    // copy prev arrays (22 vertices and 20 triangles of icosahedron)
+    std::vector<float> tmpVertices = vertices;
+    std::vector<float> tmpTexCoords = texCoords;
+    std::vector<unsigned int> tmpIndices = indices;
+    int faceCount = (int)tmpIndices.size() / 3;
+    std::size_t baseVertexCount = tmpVertices.size() / 3;
+
+    // find the edge slots: same pair of base indices = same edge vertices
+    std::vector<int> edgeSlots(faceCount * 3);
+    std::vector<char> edgeOwners(faceCount * 3);
+    int edgeSlotCount = 0;
+    for (int i = 0; i < faceCount * 3; ++i)
     {
-        // get 3 indices of each icosahedron triangle
-        icoI1 = tmpIndices[i];
-        icoI2 = tmpIndices[i + 1];
-        icoI3 = tmpIndices[i + 2];
-
-        // get 3 vertex attribs from icosahedron triangle
-        icoV1 = &tmpVertices[icoI1 * 3];
-        icoV2 = &tmpVertices[icoI2 * 3];
-        icoV3 = &tmpVertices[icoI3 * 3];
-        icoT1 = &tmpTexCoords[icoI1 * 2];
-        icoT2 = &tmpTexCoords[icoI2 * 2];
-        icoT3 = &tmpTexCoords[icoI3 * 2];
-
-        // reset and remember previous indices
-        prevIs.clear();
-        prevIs.push_back(icoI1);  // initial prev indices
-
-        // find new vertices by subdividing edges
-        for (j = 1; j <= subdivision; ++j)
+        unsigned int a = tmpIndices[(i / 3) * 3 + EDGE_ENDS[i % 3][0]];
+        unsigned int b = tmpIndices[(i / 3) * 3 + EDGE_ENDS[i % 3][1]];
+        edgeSlots[i] = -1;
+        for (int j = 0; j < i && edgeSlots[i] < 0; ++j)
         {
-            // find 2 end vertex attribs on the edges of the current row
-            if (j == subdivision)
-            {
-                edgeV1[0] = icoV2[0]; edgeV1[1] = icoV2[1]; edgeV1[2] = icoV2[2];
-                edgeV2[0] = icoV3[0]; edgeV2[1] = icoV3[1]; edgeV2[2] = icoV3[2];
-                edgeT1[0] = icoT2[0]; edgeT1[1] = icoT2[1];
-                edgeT2[0] = icoT3[0]; edgeT2[1] = icoT3[1];
-                edgeI1 = icoI2;
-                edgeI2 = icoI3;
-            }
-            else
-            {
-                a = (float)j / subdivision;    // lerp alpha
-                Icosphere::interpolateVertex(icoV1, icoV2, a, radius, edgeV1);
-                Icosphere::interpolateVertex(icoV1, icoV3, a, radius, edgeV2);
-                Icosphere::interpolateTexCoord(icoT1, icoT2, a, edgeT1);
-                Icosphere::interpolateTexCoord(icoT1, icoT3, a, edgeT2);
-                computeVertexNormal(edgeV1, edgeN1);
-                computeVertexNormal(edgeV2, edgeN2);
-                edgeI1 = addSubVertexAttribs(edgeV1, edgeN1, edgeT1);
-                edgeI2 = addSubVertexAttribs(edgeV2, edgeN2, edgeT2);
-            }
+            unsigned int c = tmpIndices[(j / 3) * 3 + EDGE_ENDS[j % 3][0]];
+            unsigned int d = tmpIndices[(j / 3) * 3 + EDGE_ENDS[j % 3][1]];
+            if ((a == c && b == d) || (a == d && b == c))
+                edgeSlots[i] = edgeSlots[j];
+        }
+        edgeOwners[i] = edgeSlots[i] < 0;
+        if (edgeOwners[i])
+            edgeSlots[i] = edgeSlotCount++;
+    }
 
-            // build indices of the current row first
-            currIs.clear();
-            for (k = 0; k <= j; ++k)
-            {
-                if (k == 0)
-                    currIs.push_back(edgeI1);
-                else if (k == j)
-                    currIs.push_back(edgeI2);
-                else
-                {
-                    float newV[3], newN[3], newT[2];
-                    a = (float)k / j;
-                    Icosphere::interpolateVertex(edgeV1, edgeV2, a, radius, newV);
-                    Icosphere::interpolateTexCoord(edgeT1, edgeT2, a, newT);
-                    computeVertexNormal(newV, newN);
-                    unsigned int newI = addSubVertexAttribs(newV, newN, newT);
-                    currIs.push_back(newI);
-                }
-            }
+    // presize the arrays with the closed-form counts (the base vertices stay in front)
+    std::size_t n = subdivision;
+    std::size_t vertexCount = baseVertexCount + edgeSlotCount * (n - 1) + faceCount * (n - 1) * (n - 2) / 2;
+    vertices.resize(vertexCount * 3);
+    normals.resize(vertexCount * 3);
+    texCoords.resize(vertexCount * 2);
+    indices.resize(faceCount * 3 * n * n);
+    lineIndices.resize(faceCount * 4 * n * n);
+
+    runPerFace(faceCount, [&](int faceBegin, int faceEnd)
+    {
+        for (int face = faceBegin; face < faceEnd; ++face)
+            subdivideFaceSmooth(face, tmpVertices.data(), tmpTexCoords.data(), tmpIndices.data(), baseVertexCount,
+                                edgeSlots.data(), edgeOwners.data(), edgeSlotCount);
+    });
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// subdivide a triangle of icosahedron for smooth shading
+// writes the vertices of the owned edges and the inside of the face, and the
+// triangle/line indices of the face
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::subdivideFaceSmooth(int face, const float* baseVertices, const float* baseTexCoords,
+                                    const unsigned int* baseIndices, std::size_t baseVertexCount,
+                                    const int* edgeSlots, const char* edgeOwners, int edgeSlotCount)
+{
+    const int n = subdivision;
+    const unsigned int* icoI = &baseIndices[face * 3];
+    const float* icoV1 = &baseVertices[icoI[0] * 3];
+    const float* icoV2 = &baseVertices[icoI[1] * 3];
+    const float* icoV3 = &baseVertices[icoI[2] * 3];
+    const float* icoT1 = &baseTexCoords[icoI[0] * 2];
+    const float* icoT2 = &baseTexCoords[icoI[1] * 2];
+    const float* icoT3 = &baseTexCoords[icoI[2] * 2];
+
+    std::size_t edgeBase = baseVertexCount;
+    std::size_t innerBase = baseVertexCount + edgeSlotCount * (std::size_t)(n - 1) +
+                            face * (std::size_t)(n - 1) * (n - 2) / 2;
+
+    // write the vertex attribs at the given index
+    float* vertexData = vertices.data();
+    float* normalData = normals.data();
+    float* texCoordData = texCoords.data();
+    auto setVertex = [&](std::size_t index, const float v[3], const float t[2])
+    {
+        vertexData[index * 3] = v[0];
+        vertexData[index * 3 + 1] = v[1];
+        vertexData[index * 3 + 2] = v[2];
+        Icosphere::computeVertexNormal(v, &normalData[index * 3]);
+        texCoordData[index * 2] = t[0];
+        texCoordData[index * 2 + 1] = t[1];
+    };
+
+    // index of the vertex at "step" (0..N) on edge e, counted from its 1st end
+    // edge vertices are stored from the lower base index to the higher one
+    auto edgeIndex = [&](int e, int step) -> unsigned int
+    {
+        unsigned int a = icoI[EDGE_ENDS[e][0]];
+        unsigned int b = icoI[EDGE_ENDS[e][1]];
+        if (step == 0)
+            return a;
+        if (step == n)
+            return b;
+        int m = (a < b) ? step : n - step;
+        return (unsigned int)(edgeBase + edgeSlots[face * 3 + e] * (std::size_t)(n - 1) + (m - 1));
+    };
+
+    // index of sub-vertex k on row j (row 0 is the top vertex, row N the bottom edge)
+    auto pointIndex = [&](int j, int k) -> unsigned int
+    {
+        if (k == 0)
+            return edgeIndex(0, j);         // left edge, v1-v2
+        if (k == j)
+            return edgeIndex(1, j);         // right edge, v1-v3
+        if (j == n)
+            return edgeIndex(2, k);         // bottom edge, v2-v3
+        return (unsigned int)(innerBase + (std::size_t)(j - 1) * (j - 2) / 2 + (k - 1));
+    };
+
+    // vertices on the edges owned by this face
+    float newV[3], newT[2];
+    for (int e = 0; e < 3; ++e)
+    {
+        if (!edgeOwners[face * 3 + e])
+            continue;
+
+        unsigned int a = icoI[EDGE_ENDS[e][0]];
+        unsigned int b = icoI[EDGE_ENDS[e][1]];
+        unsigned int lo = std::min(a, b), hi = std::max(a, b);
+        for (int m = 1; m < n; ++m)
+        {
+            float alpha = (float)m / n;
+            Icosphere::interpolateVertex(&baseVertices[lo * 3], &baseVertices[hi * 3], alpha, radius, newV);
+            Icosphere::interpolateTexCoord(&baseTexCoords[lo * 2], &baseTexCoords[hi * 2], alpha, newT);
+            setVertex(edgeBase + edgeSlots[face * 3 + e] * (std::size_t)(n - 1) + (m - 1), newV, newT);
+        }
+    }
+
+    // vertices inside the face, interpolated between the left/right edges of each row
+    float edgeV1[3], edgeV2[3], edgeT1[2], edgeT2[2];
+    for (int j = 2; j < n; ++j)
+    {
+        float a = (float)j / n;
+        Icosphere::interpolateVertex(icoV1, icoV2, a, radius, edgeV1);
+        Icosphere::interpolateVertex(icoV1, icoV3, a, radius, edgeV2);
+        Icosphere::interpolateTexCoord(icoT1, icoT2, a, edgeT1);
+        Icosphere::interpolateTexCoord(icoT1, icoT3, a, edgeT2);
+        for (int k = 1; k < j; ++k)
+        {
+            a = (float)k / j;
+            Icosphere::interpolateVertex(edgeV1, edgeV2, a, radius, newV);
+            Icosphere::interpolateTexCoord(edgeT1, edgeT2, a, newT);
+            setVertex(pointIndex(j, k), newV, newT);
+        }
+    }
+
+    // triangle and line indices, same order as row-by-row subdivision
+    unsigned int* indexOut = &indices[face * 3 * (std::size_t)n * n];
+    unsigned int* lineOut = &lineIndices[face * 4 * (std::size_t)n * n];
+    for (int j = 1; j <= n; ++j)
+    {
+        for (int k = 0; k < j; ++k)
+        {
+            unsigned int i1 = pointIndex(j - 1, k); // index from prev row
+            unsigned int i2 = pointIndex(j, k);     // new 2 vertices on current row
+            unsigned int i3 = pointIndex(j, k + 1);
 
-            for (k = 0; k < j; ++k)
+            *indexOut++ = i1; *indexOut++ = i2; *indexOut++ = i3;
+            *lineOut++ = i1; *lineOut++ = i2;
+            *lineOut++ = i2; *lineOut++ = i3;
+
+            if (k < j - 1)
             {
-                // index from prev row
-                i1 = prevIs[k];
-
-                // new 2 vertices on current row
-                i2 = currIs[k];
-                i3 = currIs[k + 1];
-
-                // add indices
-                addIndices(i1, i2, i3);
-
-                // add indices for edge lines
-                addLineIndices(i1, i2);
-                addLineIndices(i2, i3);
-
-                if (k < j - 1)
-                {
-                    i4 = prevIs[k + 1];
-                    addIndices(i3, i4, i1);
-                    addLineIndices(i1, i3);
-                    addLineIndices(i1, i4);
-                }
+                unsigned int i4 = pointIndex(j - 1, k + 1);
+                *indexOut++ = i3; *indexOut++ = i4; *indexOut++ = i1;
+                *lineOut++ = i1; *lineOut++ = i3;
+                *lineOut++ = i1; *lineOut++ = i4;
             }
-            // for next row
-            prevIs.swap(currIs);
         }
     }
 }
@@ -905,28 +1093,260 @@ void Icosphere::subdivideVerticesSmooth()
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// generate interleaved vertices: V/N/T
-// stride must be 32 bytes
+// call func(faceBegin, faceEnd) for the faces of icosahedron, one face per
+// tile on the job system for high subdivisions (each face writes disjoint
+// ranges); the calling thread runs tiles too while it waits
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::runPerFace(int faceCount, const std::function<void(int, int)>& func) const
+{
+    if (!jobs || jobs->getWorkerCount() == 0 || subdivision < MIN_PARALLEL_SUBDIVISION)
+    {
+        func(0, faceCount);
+        return;
+    }
+
+    JobSystem::Fence fence;
+    jobs->parallelFor((std::size_t)faceCount, 1, [&func](std::size_t begin, std::size_t end)
+    {
+        func((int)begin, (int)end);
+    }, fence);
+    jobs->wait(fence);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// generate interleaved vertices: V/N/T in the layout of vertexFormat
+// VERTEX_FORMAT_FLOAT:  stride 32 bytes
+//      0: position  3 x GL_FLOAT
+//     12: normal    3 x GL_FLOAT
+//     24: texcoord  2 x GL_FLOAT
+// VERTEX_FORMAT_PACKED: stride 16 bytes
+//      0: position  3 x GL_HALF_FLOAT (+2 bytes padding, attribs are 4-byte aligned)
+//      8: normal    GL_INT_2_10_10_10_REV, normalized (w = 0)
+//     12: texcoord  2 x GL_UNSIGNED_SHORT, normalized
 ///////////////////////////////////////////////////////////////////////////////
 void Icosphere::buildInterleavedVertices()
 {
-    std::vector<float>().swap(interleavedVertices);
+    setInterleavedLayout();
+
+    std::size_t count = vertices.size() / 3;
+    interleavedVertices.resize(count * interleavedStride);
+    interleavedVertices.shrink_to_fit();
+
+    unsigned char* out = interleavedVertices.data();
+    for (std::size_t i = 0; i < count; ++i, out += interleavedStride)
+        writeInterleavedVertex(&vertices[i * 3], &normals[i * 3], &texCoords[i * 2], out);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// stride and attribs of vertexFormat, the buffers are re-uploaded on the next
+// draw
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::setInterleavedLayout()
+{
+    buffersDirty = true;                    // re-upload on the next draw
+    positionsDirty = false;
 
-    std::size_t i, j;
-    std::size_t count = vertices.size();
-    for (i = 0, j = 0; i < count; i += 3, j += 2)
+    if (vertexFormat == VERTEX_FORMAT_PACKED)
     {
-        interleavedVertices.push_back(vertices[i]);
-        interleavedVertices.push_back(vertices[i + 1]);
-        interleavedVertices.push_back(vertices[i + 2]);
+        interleavedStride = 16;
+        interleavedAttribs[ATTRIB_POSITION] = { 3, GL_HALF_FLOAT, false, 0 };
+        interleavedAttribs[ATTRIB_NORMAL] = { 4, GL_INT_2_10_10_10_REV, true, 8 };
+        interleavedAttribs[ATTRIB_TEXCOORD] = { 2, GL_UNSIGNED_SHORT, true, 12 };
+    }
+    else
+    {
+        interleavedStride = 32;
+        interleavedAttribs[ATTRIB_POSITION] = { 3, GL_FLOAT, false, 0 };
+        interleavedAttribs[ATTRIB_NORMAL] = { 3, GL_FLOAT, false, 12 };
+        interleavedAttribs[ATTRIB_TEXCOORD] = { 2, GL_FLOAT, false, 24 };
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// write 1 vertex at out in the layout of vertexFormat
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::writeInterleavedVertex(const float v[3], const float n[3], const float t[2], unsigned char* out) const
+{
+    if (vertexFormat == VERTEX_FORMAT_PACKED)
+    {
+        unsigned short position[4] = { toHalfFloat(v[0]), toHalfFloat(v[1]), toHalfFloat(v[2]), 0 };
+        unsigned int normal = packNormal(n);
+        unsigned short texCoord[2] = { toUnorm16(t[0]), toUnorm16(t[1]) };
+        std::memcpy(out, position, 8);
+        std::memcpy(out + 8, &normal, 4);
+        std::memcpy(out + 12, texCoord, 4);
+    }
+    else
+    {
+        std::memcpy(out, v, 12);
+        std::memcpy(out + 12, n, 12);
+        std::memcpy(out + 24, t, 8);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// reorder the triangles for the GPU post-transform vertex cache (Tipsify,
+// Sander et al. 2007, made for a FIFO cache of cacheSize entries), then
+// renumber the vertices in the order they are first used, so vertex fetch
+// also walks the buffer forward
+// The new order is kept only if it lowers the simulated ACMR.
+// Call it again after setSubdivision()/setSmooth(), those rebuild the arrays.
+// A flat sphere shares no vertices (every index is a miss in any order), and
+// its vertices are already numbered by first use: nothing to do.
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::optimizeVertexCache(int cacheSize)
+{
+    cacheSize = std::max(cacheSize, 4);
+    const std::size_t triangleCount = indices.size() / 3;
+    const std::size_t vertexCount = vertices.size() / 3;
+    if (triangleCount == 0 || !smooth)
+        return;
+
+    // triangles of each vertex (compressed: adjacencyStart[v] .. adjacencyStart[v+1])
+    std::vector<unsigned int> liveCounts(vertexCount, 0);   // # of triangles not emitted yet
+    for (std::size_t i = 0; i < indices.size(); ++i)
+        ++liveCounts[indices[i]];
+    std::vector<unsigned int> adjacencyStart(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        adjacencyStart[v + 1] = adjacencyStart[v] + liveCounts[v];
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (std::size_t i = 0; i < indices.size(); ++i)
+        adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+
+    // fan around a vertex, emitting all its triangles, then move to the
+    // neighbour that is still in the cache and will stay there while its own
+    // fan is emitted; dead ends fall back to recent vertices, then a scan
+    std::vector<int> cacheTimes(vertexCount, 0);            // time stamp when the vertex entered the cache
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<unsigned int> deadEnds, candidates;
+    std::vector<unsigned int> newIndices;
+    newIndices.reserve(indices.size());
+    int time = cacheSize + 1;
+    std::size_t scanCursor = 1;
+    long long fan = 0;
+    while (fan >= 0)
+    {
+        candidates.clear();
+        for (unsigned int a = adjacencyStart[fan]; a < adjacencyStart[fan + 1]; ++a)
+        {
+            unsigned int t = adjacency[a];
+            if (emitted[t])
+                continue;
+            for (int i = 0; i < 3; ++i)
+            {
+                unsigned int v = indices[t * 3 + i];
+                newIndices.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --liveCounts[v];
+                if (time - cacheTimes[v] > cacheSize)
+                    cacheTimes[v] = time++;                 // miss, enters the FIFO
+            }
+            emitted[t] = 1;
+        }
+
+        // next fan: the oldest cached candidate that survives its own fan
+        fan = -1;
+        int bestPriority = -1;
+        for (std::size_t i = 0; i < candidates.size(); ++i)
+        {
+            unsigned int v = candidates[i];
+            if (liveCounts[v] == 0)
+                continue;
+            int priority = 0;
+            if (time - cacheTimes[v] + 2 * (int)liveCounts[v] <= cacheSize)
+                priority = time - cacheTimes[v];
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                fan = v;
+            }
+        }
+        while (fan < 0 && !deadEnds.empty())
+        {
+            unsigned int v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveCounts[v] > 0)
+                fan = v;
+        }
+        while (fan < 0 && scanCursor < vertexCount)
+        {
+            if (liveCounts[scanCursor] > 0)
+                fan = (long long)scanCursor;
+            ++scanCursor;
+        }
+    }
 
-        interleavedVertices.push_back(normals[i]);
-        interleavedVertices.push_back(normals[i + 1]);
-        interleavedVertices.push_back(normals[i + 2]);
+    unsigned int oldMisses = simulateVertexCache(indices.data(), indices.size(), vertexCount, cacheSize);
+    unsigned int newMisses = simulateVertexCache(newIndices.data(), newIndices.size(), vertexCount, cacheSize);
+    if (newMisses < oldMisses)
+        indices.swap(newIndices);
 
-        interleavedVertices.push_back(texCoords[j]);
-        interleavedVertices.push_back(texCoords[j + 1]);
+    // vertex fetch order: number the vertices by first use
+    std::vector<unsigned int> remap(vertexCount, ~0u);
+    unsigned int next = 0;
+    for (std::size_t i = 0; i < indices.size(); ++i)
+    {
+        if (remap[indices[i]] == ~0u)
+            remap[indices[i]] = next++;
+    }
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        if (remap[v] == ~0u)
+            remap[v] = next++;             // unused vertices go last
     }
+
+    std::vector<float> newVertices(vertices.size());
+    std::vector<float> newNormals(normals.size());
+    std::vector<float> newTexCoords(texCoords.size());
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        std::size_t n = remap[v];
+        std::memcpy(&newVertices[n * 3], &vertices[v * 3], 3 * sizeof(float));
+        std::memcpy(&newNormals[n * 3], &normals[v * 3], 3 * sizeof(float));
+        std::memcpy(&newTexCoords[n * 2], &texCoords[v * 2], 2 * sizeof(float));
+    }
+    vertices.swap(newVertices);
+    normals.swap(newNormals);
+    texCoords.swap(newTexCoords);
+    for (std::size_t i = 0; i < indices.size(); ++i)
+        indices[i] = remap[indices[i]];
+    for (std::size_t i = 0; i < lineIndices.size(); ++i)
+        lineIndices[i] = remap[lineIndices[i]];
+
+    buildInterleavedVertices();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// cache statistics of the current triangle order
+// ACMR: transformed vertices / triangles, 0.5 is the limit for a large grid
+// ATVR: transformed vertices / vertices, 1.0 means every vertex once
+///////////////////////////////////////////////////////////////////////////////
+float Icosphere::getAcmr(int cacheSize) const
+{
+    if (indices.empty())
+        return 0.0f;
+    unsigned int misses = simulateVertexCache(indices.data(), indices.size(), getVertexCount(), cacheSize);
+    return (float)misses / getTriangleCount();
+}
+
+float Icosphere::getAtvr(int cacheSize) const
+{
+    if (indices.empty())
+        return 0.0f;
+    unsigned int misses = simulateVertexCache(indices.data(), indices.size(), getVertexCount(), cacheSize);
+    return (float)misses / getVertexCount();
 }
 
 
@@ -990,50 +1410,6 @@ void Icosphere::addLineIndices(unsigned int i1, unsigned int i2)
 
 
 
-///////////////////////////////////////////////////////////////////////////////
-// add a subdivided vertex attribs (vertex, normal, texCoord) to arrays, then
-// return its index value
-// If it is a shared vertex, remember its index, so it can be re-used
-///////////////////////////////////////////////////////////////////////////////
-unsigned int Icosphere::addSubVertexAttribs(const float v[3], const float n[3], const float t[2])
-{
-    unsigned int index;     // return value;
-
-    // check if is shared vertex or not first
-    if (Icosphere::isSharedTexCoord(t))
-    {
-        // find if it does already exist in sharedIndices map using (s,t) key
-        // if not in the list, add the vertex attribs to arrays and return its index
-        // if exists, return the current index
-        std::pair<float, float> key = std::make_pair(t[0], t[1]);
-        std::map<std::pair<float, float>, unsigned int>::iterator iter = sharedIndices.find(key);
-        if (iter == sharedIndices.end())
-        {
-            vertices.insert(vertices.end(), v, v + 3);
-            normals.insert(normals.end(), n, n + 3);
-            texCoords.insert(texCoords.end(), t, t + 2);
-            index = texCoords.size() / 2 - 1;
-            sharedIndices[key] = index;
-        }
-        else
-        {
-            index = iter->second;
-        }
-    }
-    // not shared
-    else
-    {
-        vertices.insert(vertices.end(), v, v + 3);
-        normals.insert(normals.end(), n, n + 3);
-        texCoords.insert(texCoords.end(), t, t + 2);
-        index = texCoords.size() / 2 - 1;
-    }
-
-    return index;
-}
-
-
-
 
 // static functions ===========================================================
 ///////////////////////////////////////////////////////////////////////////////
@@ -1140,77 +1516,93 @@ float Icosphere::lerp(float from, float to, float alpha)
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// This function used 20 non-shared line segments to determine if the given
-// texture coordinate is shared or no. If it is on the line segments, it is also
-// non-shared point
-//   00  01  02  03  04         //
-//   /\  /\  /\  /\  /\         //
-//  /  \/  \/  \/  \/  \        //
-// 05  06  07  08  09   \       //
-//   \   10  11  12  13  14     //
-//    \  /\  /\  /\  /\  /      //
-//     \/  \/  \/  \/  \/       //
-//      15  16  17  18  19      //
+// convert float to IEEE 754 half float, round to nearest even
+// (overflow becomes infinity, values below the half denormals become 0)
 ///////////////////////////////////////////////////////////////////////////////
-bool Icosphere::isSharedTexCoord(const float t[2])
+unsigned short Icosphere::toHalfFloat(float value)
 {
-    // 20 non-shared line segments
-    //const float S = 1.0f / 11;  // texture steps
-    //const float T = 1.0f / 3;
-    const float S = 186 / 2048.0f;     // horizontal texture step
-    const float T = 322 / 1024.0f;     // vertical texture step
-    static float segments[] = { S, 0,       0, T,       // 00 - 05
-                                S, 0,       S * 2, T,     // 00 - 06
-                                S * 3, 0,     S * 2, T,     // 01 - 06
-                                S * 3, 0,     S * 4, T,     // 01 - 07
-                                S * 5, 0,     S * 4, T,     // 02 - 07
-                                S * 5, 0,     S * 6, T,     // 02 - 08
-                                S * 7, 0,     S * 6, T,     // 03 - 08
-                                S * 7, 0,     S * 8, T,     // 03 - 09
-                                S * 9, 0,     S * 8, T,     // 04 - 09
-                                S * 9, 0,     1, T * 2,     // 04 - 14
-                                0, T,       S * 2, 1,     // 05 - 15
-                                S * 3, T * 2,   S * 2, 1,     // 10 - 15
-                                S * 3, T * 2,   S * 4, 1,     // 10 - 16
-                                S * 5, T * 2,   S * 4, 1,     // 11 - 16
-                                S * 5, T * 2,   S * 6, 1,     // 11 - 17
-                                S * 7, T * 2,   S * 6, 1,     // 12 - 17
-                                S * 7, T * 2,   S * 8, 1,     // 12 - 18
-                                S * 9, T * 2,   S * 8, 1,     // 13 - 18
-                                S * 9, T * 2,   S * 10, 1,    // 13 - 19
-                                1, T * 2,     S * 10, 1 };  // 14 - 19
-
-    // check the point with all 20 line segments
-    // if it is on the line segment, it is non-shared
-    int count = (int)(sizeof(segments) / sizeof(segments[0]));
-    for (int i = 0, j = 2; i < count; i += 4, j += 4)
+    unsigned int bits;
+    std::memcpy(&bits, &value, 4);
+
+    unsigned int sign = (bits >> 16) & 0x8000;
+    unsigned int mantissa = bits & 0x007fffff;
+    int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+
+    if ((bits & 0x7fffffff) >= 0x7f800000)     // inf or NaN
+        return (unsigned short)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    if (exponent >= 31)                         // too large
+        return (unsigned short)(sign | 0x7c00);
+
+    unsigned int half, rest, halfway;
+    if (exponent <= 0)                          // denormal half
+    {
+        if (exponent < -10)
+            return (unsigned short)sign;
+        mantissa |= 0x00800000;
+        int shift = 14 - exponent;
+        half = mantissa >> shift;
+        rest = mantissa & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    }
+    else
     {
-        if (Icosphere::isOnLineSegment(&segments[i], &segments[j], t))
-            return false;   // not shared
+        half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+        rest = mantissa & 0x1fff;
+        halfway = 0x1000;
     }
+    if (rest > halfway || (rest == halfway && (half & 1)))
+        ++half;                                 // may carry into the exponent, still correct
+    return (unsigned short)(sign | half);
+}
+
 
-    return true;
+
+///////////////////////////////////////////////////////////////////////////////
+// pack a unit normal to GL_INT_2_10_10_10_REV (x: bit 0-9, y: 10-19,
+// z: 20-29 as signed normalized 10-bit, w = 0)
+///////////////////////////////////////////////////////////////////////////////
+unsigned int Icosphere::packNormal(const float n[3])
+{
+    unsigned int packed = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        float c = std::max(-1.0f, std::min(1.0f, n[i]));
+        int value = (int)std::lround(c * 511.0f);
+        packed |= ((unsigned int)value & 0x3ff) << (i * 10);
+    }
+    return packed;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// determine a point c is on the line segment a-b
+// convert [0,1] to unsigned normalized 16-bit
 ///////////////////////////////////////////////////////////////////////////////
-bool Icosphere::isOnLineSegment(const float a[2], const float b[2], const float c[2])
+unsigned short Icosphere::toUnorm16(float value)
 {
-    const float EPSILON = 0.0001f;
+    float c = std::max(0.0f, std::min(1.0f, value));
+    return (unsigned short)std::lround(c * 65535.0f);
+}
 
-    // cross product must be 0 if c is on the line
-    float cross = ((b[0] - a[0]) * (c[1] - a[1])) - ((b[1] - a[1]) * (c[0] - a[0]));
-    if (cross > EPSILON || cross < -EPSILON)
-        return false;
 
-    // c must be within a-b
-    if ((c[0] > a[0] && c[0] > b[0]) || (c[0] < a[0] && c[0] < b[0]))
-        return false;
-    if ((c[1] > a[1] && c[1] > b[1]) || (c[1] < a[1] && c[1] < b[1]))
-        return false;
 
-    return true;    // all passed, it is on the line segment
+///////////////////////////////////////////////////////////////////////////////
+// count the vertex transforms of an indexed triangle list through a FIFO
+// post-transform cache of cacheSize entries
+///////////////////////////////////////////////////////////////////////////////
+unsigned int Icosphere::simulateVertexCache(const unsigned int* indices, std::size_t count, std::size_t vertexCount, int cacheSize)
+{
+    // a vertex is cached if it entered the FIFO within the last cacheSize misses
+    std::vector<unsigned int> insertedAt(vertexCount, 0);   // miss counter + 1 when it entered, 0 = never
+    unsigned int misses = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        unsigned int v = indices[i];
+        if (insertedAt[v] == 0 || misses - (insertedAt[v] - 1) >= (unsigned int)cacheSize)
+        {
+            insertedAt[v] = misses + 1;
+            ++misses;
+        }
+    }
+    return misses;
 }
@@ -5,6 +5,11 @@
 // The icosphere with N=2 (default) has 80 triangles by subdividing a triangle
 // of icosahedron into 4 triangles. If N=1, it is identical to icosahedron.
 //
+// NOTE: a flat sphere (smooth = false) keeps its vertices in the interleaved
+// array only: getVertices(), getNormals(), getTexCoords() and their count and
+// size getters return empty data for it. Read the flat vertices through
+// getInterleavedVertices() and getInterleavedAttrib() instead.
+//
 //  AUTHOR: Song Ho Ahn (song.ahn@gmail.com)
 // CREATED: 2018-07-23
 // UPDATED: 2024-09-05
@@ -14,54 +19,107 @@
 #define GEOMETRY_ICOSPHERE_H
 
 #include <vector>
-#include <map>
+#include <functional>
+#include <cstddef>
+#include <memory>
+
+class IcosphereBuffers;
+class JobSystem;
 
 class Icosphere
 {
 public:
+    // layout of the interleaved vertices
+    enum VertexFormat
+    {
+        VERTEX_FORMAT_FLOAT,                // 32 bytes: position 3 float, normal 3 float, texcoord 2 float
+        VERTEX_FORMAT_PACKED                // 16 bytes: position 3 half float (+2 pad), normal 2_10_10_10 snorm, texcoord 2 unorm16
+    };
+
+    // attribs of an interleaved vertex, in this order
+    enum VertexAttribName
+    {
+        ATTRIB_POSITION,
+        ATTRIB_NORMAL,
+        ATTRIB_TEXCOORD,
+        ATTRIB_COUNT
+    };
+
+    // description of 1 attrib, as the params of glVertexAttribPointer()
+    struct VertexAttrib
+    {
+        int size;                           // # of components
+        unsigned int type;                  // GL type, e.g. GL_FLOAT, GL_HALF_FLOAT, GL_INT_2_10_10_10_REV
+        bool normalized;                    // integer types are read as [0,1] or [-1,1]
+        unsigned int offset;                // # of bytes from the start of the vertex
+    };
+
     // ctor/dtor
-    Icosphere(float radius = 1.0f, int subdivision = 2, bool smooth = false);
-    ~Icosphere() {}
+    // high subdivisions split the faces over the job system if one is given (not owned)
+    Icosphere(float radius = 1.0f, int subdivision = 2, bool smooth = false, VertexFormat format = VERTEX_FORMAT_FLOAT,
+              JobSystem* jobs = 0);
+    ~Icosphere();
+    Icosphere(const Icosphere&) = delete;
+    Icosphere& operator=(const Icosphere&) = delete;
 
     // getters/setters
     float getRadius() const { return radius; }
-    void setRadius(float radius);
+    void setRadius(float radius);           // patches the positions in place (flat packed spheres are rebuilt), the next getBuffers() re-uploads the VBO
     int getSubdivision() const { return subdivision; }
     void setSubdivision(int subdivision);
     bool getSmooth() const { return smooth; }
     void setSmooth(bool smooth);
+    VertexFormat getVertexFormat() const { return vertexFormat; }
+    void setVertexFormat(VertexFormat format);
     void reverseNormals();
+    void optimizeVertexCache(int cacheSize = 32);      // reorder triangles (Tipsify) and vertices (first use), smooth spheres only
+    void setJobSystem(JobSystem* jobs) { this->jobs = jobs; }      // for the next rebuild, 0 = calling thread only
+
+    // 12 vertices of the base icosahedron at the current radius (x,y,z each): north pole, upper row of 5,
+    // lower row of 5, south pole
+    std::vector<float> computeIcosahedronVertices() const;
 
     // for vertex data
-    unsigned int getVertexCount() const { return (unsigned int)vertices.size() / 3; }
-    unsigned int getNormalCount() const { return (unsigned int)normals.size() / 3; }
-    unsigned int getTexCoordCount() const { return (unsigned int)texCoords.size() / 2; }
+    // the separate V/N/T arrays are kept for smooth spheres only, a flat sphere writes its
+    // 60N^2 unshared vertices straight into the interleaved array (getVertexCount() counts both)
+    unsigned int getVertexCount() const { return (unsigned int)(interleavedVertices.size() / interleavedStride); }
+    unsigned int getNormalCount() const { return (unsigned int)normals.size() / 3; }         // smooth only, 0 if flat
+    unsigned int getTexCoordCount() const { return (unsigned int)texCoords.size() / 2; }     // smooth only, 0 if flat
     unsigned int getIndexCount() const { return (unsigned int)indices.size(); }
     unsigned int getLineIndexCount() const { return (unsigned int)lineIndices.size(); }
     unsigned int getTriangleCount() const { return getIndexCount() / 3; }
 
-    unsigned int getVertexSize() const { return (unsigned int)vertices.size() * sizeof(float); }   // # of bytes
-    unsigned int getNormalSize() const { return (unsigned int)normals.size() * sizeof(float); }
-    unsigned int getTexCoordSize() const { return (unsigned int)texCoords.size() * sizeof(float); }
+    unsigned int getVertexSize() const { return (unsigned int)vertices.size() * sizeof(float); }   // # of bytes, smooth only, 0 if flat
+    unsigned int getNormalSize() const { return (unsigned int)normals.size() * sizeof(float); }     // smooth only, 0 if flat
+    unsigned int getTexCoordSize() const { return (unsigned int)texCoords.size() * sizeof(float); } // smooth only, 0 if flat
     unsigned int getIndexSize() const { return (unsigned int)indices.size() * sizeof(unsigned int); }
     unsigned int getLineIndexSize() const { return (unsigned int)lineIndices.size() * sizeof(unsigned int); }
 
-    const float* getVertices() const { return vertices.data(); }
-    const float* getNormals() const { return normals.data(); }
-    const float* getTexCoords() const { return texCoords.data(); }
+    const float* getVertices() const { return vertices.data(); }     // smooth only, empty if flat
+    const float* getNormals() const { return normals.data(); }       // smooth only, empty if flat
+    const float* getTexCoords() const { return texCoords.data(); }   // smooth only, empty if flat
     const unsigned int* getIndices() const { return indices.data(); }
     const unsigned int* getLineIndices() const { return lineIndices.data(); }
 
-    // for interleaved vertices: V/N/T
+    // for interleaved vertices: V/N/T in the layout of getVertexFormat()
     unsigned int getInterleavedVertexCount() const { return getVertexCount(); }    // # of vertices
-    unsigned int getInterleavedVertexSize() const { return (unsigned int)interleavedVertices.size() * sizeof(float); }    // # of bytes
-    int getInterleavedStride() const { return interleavedStride; }   // should be 32 bytes
-    const float* getInterleavedVertices() const { return interleavedVertices.data(); }
+    unsigned int getInterleavedVertexSize() const { return (unsigned int)interleavedVertices.size(); }    // # of bytes
+    int getInterleavedStride() const { return interleavedStride; }   // 32 or 16 bytes
+    const void* getInterleavedVertices() const { return interleavedVertices.data(); }
+    const VertexAttrib& getInterleavedAttrib(int attrib) const { return interleavedAttribs[attrib]; }
 
-    // draw in VertexArray mode
+    // draw from buffer objects (VAO/VBO/EBO, attrib 0/1/2 = V/N/T), created on the first draw
+    // and re-uploaded after the vertices change; a shader must be bound by the caller
     void draw() const;
-    void drawLines(const float lineColor[4]) const;
-    void drawWithLines(const float lineColor[4]) const;
+    void drawInstanced(int instanceCount) const;
+    void drawLines() const;
+    void drawWithLines() const;
+    const IcosphereBuffers& getBuffers() const;         // creates/updates the buffers if needed
+    void releaseBuffers();                              // GL context must be current
+
+    // post-transform cache efficiency of the triangle order, FIFO cache of cacheSize vertices
+    float getAcmr(int cacheSize = 32) const;           // average cache miss ratio, transformed vertices per triangle
+    float getAtvr(int cacheSize = 32) const;           // average transform to vertex ratio, 1.0 is ideal
 
     // debug
     void printSelf() const;
@@ -76,38 +134,55 @@ private:
     static void interpolateVertex(const float v1[3], const float v2[3], float alpha, float length, float newV[3]);
     static void interpolateTexCoord(const float t1[2], const float t2[2], float alpha, float newT[2]);
     static float lerp(float from, float to, float alpha);
-    static bool isSharedTexCoord(const float t[2]);
-    static bool isOnLineSegment(const float a[2], const float b[2], const float c[2]);
+    static unsigned short toHalfFloat(float value);
+    static unsigned int packNormal(const float n[3]);
+    static unsigned short toUnorm16(float value);
+    static unsigned int simulateVertexCache(const unsigned int* indices, std::size_t count, std::size_t vertexCount, int cacheSize);
 
     // member functions
+    void runPerFace(int faceCount, const std::function<void(int, int)>& func) const;
     void updateRadius();
-    std::vector<float> computeIcosahedronVertices();
     void buildVerticesFlat();
     void buildVerticesSmooth();
     void subdivideVerticesFlat();
     void subdivideVerticesSmooth();
+    void rebuildVerticesFlat();
     void buildInterleavedVertices();
+    void setInterleavedLayout();
+    void writeInterleavedVertex(const float v[3], const float n[3], const float t[2], unsigned char* out) const;
     void addVertices(const float v1[3], const float v2[3], const float v3[3]);
     void addNormals(const float n1[3], const float n2[3], const float n3[3]);
     void addTexCoords(const float t1[2], const float t2[2], const float t3[2]);
     void addIndices(unsigned int i1, unsigned int i2, unsigned int i3);
     void addLineIndices(unsigned int i1, unsigned int i2);
-    unsigned int addSubVertexAttribs(const float v[3], const float n[3], const float t[2]);
+    void subdivideFaceFlat(int face, const float* baseVertices, const float* baseTexCoords,
+                           const unsigned int* baseIndices, float* rows);
+    void subdivideFaceSmooth(int face, const float* baseVertices, const float* baseTexCoords,
+                             const unsigned int* baseIndices, std::size_t baseVertexCount,
+                             const int* edgeSlots, const char* edgeOwners, int edgeSlotCount);
 
     // memeber vars
     float radius;                           // circumscribed radius
     int subdivision;                        // subdivision frequencies
     bool smooth;
+    bool normalsReversed;                   // reverseNormals() since the last build, kept over a flat rebuild
+    JobSystem* jobs;                        // not owned, may be 0
     std::vector<float> vertices;
     std::vector<float> normals;
     std::vector<float> texCoords;
     std::vector<unsigned int> indices;
     std::vector<unsigned int> lineIndices;
-    std::map<std::pair<float, float>, unsigned int> sharedIndices;   // indices of shared vertices, key is tex coord (s,t)
 
     // interleaved
-    std::vector<float> interleavedVertices;
-    int interleavedStride;                  // # of bytes to hop to the next vertex (should be 32 bytes)
+    VertexFormat vertexFormat;
+    std::vector<unsigned char> interleavedVertices;
+    int interleavedStride;                  // # of bytes to hop to the next vertex (32 or 16 bytes)
+    VertexAttrib interleavedAttribs[ATTRIB_COUNT];
+
+    // GPU copy, owned
+    mutable std::unique_ptr<IcosphereBuffers> buffers;
+    mutable bool buffersDirty;              // vertices/indices changed since the last upload
+    mutable bool positionsDirty;            // setRadius() since the last upload, the VBO only
 
 };
 
@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////////
+// IcosphereBuffers.cpp
+// ====================
+// GPU resource object for icosphere data (VAO + VBO + EBO).
+///////////////////////////////////////////////////////////////////////////////
+
+#include <glad/glad.h>
+#include "IcosphereBuffers.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+IcosphereBuffers::IcosphereBuffers() : vao(0), vbo(0), ebo(0), indexCount(0), lineIndexCount(0)
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// upload the vertices and indices; the EBO is
+//      [triangle indices][line indices]
+// so lines and triangles share the VAO with no EBO rebinding
+///////////////////////////////////////////////////////////////////////////////
+void IcosphereBuffers::create(const void* vertices, std::size_t vertexSize, int stride, const Icosphere::VertexAttrib* attribs,
+                              const unsigned int* indices, std::size_t indexCount,
+                              const unsigned int* lineIndices, std::size_t lineIndexCount)
+{
+    if (!vao)
+    {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glGenBuffers(1, &ebo);
+    }
+    this->indexCount = (unsigned int)indexCount;
+    this->lineIndexCount = (unsigned int)lineIndexCount;
+
+    glBindVertexArray(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertexSize, vertices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    std::size_t indexSize = indexCount * sizeof(unsigned int);
+    std::size_t lineIndexSize = lineIndexCount * sizeof(unsigned int);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize + lineIndexSize, 0, GL_STATIC_DRAW);
+    if (indices)
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indexSize, indices);
+    if (lineIndices && lineIndexSize > 0)
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexSize, lineIndexSize, lineIndices);
+
+    for (int i = 0; i < Icosphere::ATTRIB_COUNT; ++i)
+    {
+        glVertexAttribPointer(i, attribs[i].size, attribs[i].type, attribs[i].normalized ? GL_TRUE : GL_FALSE,
+                              stride, (void*)(std::size_t)attribs[i].offset);
+        glEnableVertexAttribArray(i);
+    }
+
+    glBindVertexArray(0);
+}
+
+void IcosphereBuffers::updateVertices(std::size_t offset, std::size_t size, const void* data)
+{
+    if (!vbo || size == 0)
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+}
+
+// through the copy-write target, so the EBO binding of whichever VAO is bound
+// is left alone
+void IcosphereBuffers::updateIndices(std::size_t offset, std::size_t size, const void* data)
+{
+    if (!ebo || size == 0)
+        return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void IcosphereBuffers::release()
+{
+    if (!vao)
+        return;
+
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+    vao = vbo = ebo = 0;
+    indexCount = lineIndexCount = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draws; the VAO stays bound afterwards
+///////////////////////////////////////////////////////////////////////////////
+void IcosphereBuffers::drawTriangles(unsigned int count, unsigned int firstIndex, int baseVertex, int instanceCount) const
+{
+    if (!vao || count == 0 || instanceCount <= 0)
+        return;
+
+    glBindVertexArray(vao);
+    const void* offset = (const void*)((std::size_t)firstIndex * sizeof(unsigned int));
+    if (instanceCount == 1)
+        glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)offset, baseVertex);
+    else
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_INT, offset, instanceCount, baseVertex);
+}
+
+void IcosphereBuffers::drawLines(int instanceCount) const
+{
+    if (!vao || lineIndexCount == 0 || instanceCount <= 0)
+        return;
+
+    glBindVertexArray(vao);
+    const void* offset = (const void*)((std::size_t)indexCount * sizeof(unsigned int));
+    if (instanceCount == 1)
+        glDrawElements(GL_LINES, lineIndexCount, GL_UNSIGNED_INT, offset);
+    else
+        glDrawElementsInstanced(GL_LINES, lineIndexCount, GL_UNSIGNED_INT, offset, instanceCount);
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// IcosphereBuffers.h
+// ==================
+// GPU resource object for icosphere data: one VAO, one VBO with the
+// interleaved vertices and one EBO holding the triangle indices followed by
+// the line indices. Created once, every draw is a buffer-object draw with no
+// client-side copy. Usable in the 3.3 core profile.
+//
+// Attrib locations follow Icosphere::VertexAttribName: 0 position, 1 normal,
+// 2 texcoord. Other locations (e.g. per-instance data) may be added to the
+// VAO by the caller; bind getVao() first.
+//
+// A GL context with glad loaded must be current for create(), release() and
+// the draws. The destructor does not touch GL (the context may be gone), call
+// release() before the context is destroyed.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GEOMETRY_ICOSPHERE_BUFFERS_H
+#define GEOMETRY_ICOSPHERE_BUFFERS_H
+
+#include <cstddef>
+#include "Icosphere.h"
+
+class IcosphereBuffers
+{
+public:
+    // ctor/dtor
+    IcosphereBuffers();
+    ~IcosphereBuffers() {}
+    IcosphereBuffers(const IcosphereBuffers&) = delete;
+    IcosphereBuffers& operator=(const IcosphereBuffers&) = delete;
+
+    // (re)create the buffers with new data, the VAO is kept; null arrays leave
+    // the storage uninitialized for the update*() calls to fill
+    void create(const void* vertices, std::size_t vertexSize, int stride, const Icosphere::VertexAttrib* attribs,
+                const unsigned int* indices, std::size_t indexCount,
+                const unsigned int* lineIndices, std::size_t lineIndexCount);
+    void updateVertices(std::size_t offset, std::size_t size, const void* data);   // glBufferSubData of part of the VBO
+    void updateIndices(std::size_t offset, std::size_t size, const void* data);    // same for the EBO, offset in bytes
+    void release();
+    bool isCreated() const { return vao != 0; }
+
+    unsigned int getVao() const { return vao; }
+    unsigned int getVbo() const { return vbo; }
+    unsigned int getEbo() const { return ebo; }
+    unsigned int getIndexCount() const { return indexCount; }
+    unsigned int getLineIndexCount() const { return lineIndexCount; }
+
+    // triangles: count indices from firstIndex, added to baseVertex, instanceCount times
+    void drawTriangles(unsigned int count, unsigned int firstIndex = 0, int baseVertex = 0, int instanceCount = 1) const;
+    void draw(int instanceCount = 1) const { drawTriangles(indexCount, 0, 0, instanceCount); }
+    void drawLines(int instanceCount = 1) const;
+
+private:
+    unsigned int vao;
+    unsigned int vbo;
+    unsigned int ebo;
+    unsigned int indexCount;
+    unsigned int lineIndexCount;                // line indices start after the triangle indices
+};
+
+#endif
@@ -0,0 +1,243 @@
+///////////////////////////////////////////////////////////////////////////////
+// IcosphereLodChain.cpp
+// =====================
+// Levels of detail of an icosphere packed into one vertex/index array.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "IcosphereLodChain.h"
+#include "MeshCache.h"
+
+// longest triangle edge of subdivision N ~= EDGE_RATIO * radius / N
+// (edge of icosahedron / circumscribed radius = 1.0515)
+const float EDGE_RATIO = 1.0515f;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+IcosphereLodChain::IcosphereLodChain(float radius, const std::vector<int>& subdivisions, bool smooth,
+                                     Icosphere::VertexFormat format, MeshCache* cache, JobSystem* jobs)
+    : radius(radius), smooth(smooth), vertexFormat(format), maxEdgePixels(8.0f), vertexCount(0), indexCount(0),
+      interleavedStride(32), cache(cache), cacheHits(0)
+{
+    set(radius, subdivisions, smooth, format, cache, jobs);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setters
+///////////////////////////////////////////////////////////////////////////////
+void IcosphereLodChain::set(float radius, const std::vector<int>& subdivisions, bool smooth,
+                            Icosphere::VertexFormat format, MeshCache* cache, JobSystem* jobs)
+{
+    this->radius = radius;
+    this->smooth = smooth;
+    this->vertexFormat = format;
+    this->cache = cache;
+
+    // coarsest first, no duplicates
+    std::vector<int> sorted = subdivisions;
+    for (std::size_t i = 0; i < sorted.size(); ++i)
+        sorted[i] = std::max(sorted[i], 1);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    if (sorted.empty())
+        sorted.push_back(1);
+
+    levels.clear();
+    sources.clear();
+    vertexCount = indexCount = 0;
+    std::vector<unsigned char>().swap(generatedVertices);
+    std::vector<unsigned int>().swap(generatedIndices);
+
+    // lay out each level; a cached level only contributes its sizes, a
+    // generated one (then cached) is kept until createBuffers()
+    cacheHits = 0;
+    for (std::size_t i = 0; i < sorted.size(); ++i)
+    {
+        if (cache && cache->open(radius, sorted[i], smooth, format, true))
+        {
+            Icosphere::VertexAttrib attribs[Icosphere::ATTRIB_COUNT];
+            for (int j = 0; j < Icosphere::ATTRIB_COUNT; ++j)
+                attribs[j] = cache->getInterleavedAttrib(j);
+            appendLevel(sorted[i], cache->getInterleavedVertexCount(), cache->getInterleavedStride(), attribs,
+                        cache->getIndexCount(), true);
+            cache->close();
+            ++cacheHits;
+            continue;
+        }
+
+        Icosphere sphere(radius, sorted[i], smooth, format, jobs);
+        sphere.optimizeVertexCache();       // drawn once per instance, worth the reorder
+        if (cache)
+            cache->save(sphere, true);
+
+        Icosphere::VertexAttrib attribs[Icosphere::ATTRIB_COUNT];
+        for (int j = 0; j < Icosphere::ATTRIB_COUNT; ++j)
+            attribs[j] = sphere.getInterleavedAttrib(j);
+        appendLevel(sorted[i], sphere.getInterleavedVertexCount(), sphere.getInterleavedStride(), attribs,
+                    sphere.getIndexCount(), false);
+
+        const unsigned char* data = (const unsigned char*)sphere.getInterleavedVertices();
+        generatedVertices.insert(generatedVertices.end(), data, data + sphere.getInterleavedVertexSize());
+        generatedIndices.insert(generatedIndices.end(), sphere.getIndices(), sphere.getIndices() + sphere.getIndexCount());
+    }
+}
+
+void IcosphereLodChain::setMaxEdgePixels(float pixels)
+{
+    maxEdgePixels = std::max(pixels, 0.5f);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// add a level at the end of the buffers; its indices stay local, the draw adds
+// baseVertex
+///////////////////////////////////////////////////////////////////////////////
+void IcosphereLodChain::appendLevel(int subdivision, unsigned int levelVertexCount, int stride,
+                                    const Icosphere::VertexAttrib* attribs, unsigned int levelIndexCount, bool cached)
+{
+    interleavedStride = stride;
+    for (int j = 0; j < Icosphere::ATTRIB_COUNT; ++j)
+        interleavedAttribs[j] = attribs[j];
+
+    Level level;
+    level.subdivision = subdivision;
+    level.baseVertex = vertexCount;
+    level.vertexCount = levelVertexCount;
+    level.firstIndex = indexCount;
+    level.indexCount = levelIndexCount;
+    levels.push_back(level);
+
+    LevelSource source;
+    source.cached = cached;
+    source.vertexOffset = generatedVertices.size();
+    source.indexOffset = generatedIndices.size();
+    sources.push_back(source);
+
+    vertexCount += levelVertexCount;
+    indexCount += levelIndexCount;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// allocate one VAO/VBO/EBO for all levels and fill each level's range; cached
+// levels go from the mapped blob to glBufferSubData() with no copy in between
+///////////////////////////////////////////////////////////////////////////////
+void IcosphereLodChain::createBuffers()
+{
+    buffers.create(0, getInterleavedVertexSize(), interleavedStride, interleavedAttribs, 0, indexCount, 0, 0);
+
+    for (std::size_t i = 0; i < levels.size(); ++i)
+    {
+        const Level& level = levels[i];
+        if (!sources[i].cached)
+        {
+            uploadLevel((int)i, &generatedVertices[sources[i].vertexOffset], &generatedIndices[sources[i].indexOffset]);
+            continue;
+        }
+
+        if (cache && cache->open(radius, level.subdivision, smooth, vertexFormat, true) &&
+            cache->getInterleavedVertexCount() == level.vertexCount && cache->getIndexCount() == level.indexCount &&
+            cache->getInterleavedStride() == interleavedStride)
+        {
+            uploadLevel((int)i, cache->getInterleavedVertices(), cache->getIndices());
+            cache->close();
+            continue;
+        }
+
+        // the blob went away or changed since set(): generate the level again
+        if (cache)
+            cache->close();
+        Icosphere sphere(radius, level.subdivision, smooth, vertexFormat);
+        sphere.optimizeVertexCache();
+        uploadLevel((int)i, sphere.getInterleavedVertices(), sphere.getIndices());
+    }
+}
+
+void IcosphereLodChain::uploadLevel(int level, const void* vertexData, const unsigned int* levelIndices)
+{
+    const Level& l = levels[level];
+    buffers.updateVertices((std::size_t)l.baseVertex * interleavedStride, (std::size_t)l.vertexCount * interleavedStride,
+                           vertexData);
+    buffers.updateIndices((std::size_t)l.firstIndex * sizeof(unsigned int), (std::size_t)l.indexCount * sizeof(unsigned int),
+                          levelIndices);
+}
+
+void IcosphereLodChain::drawLevel(int level, int instanceCount) const
+{
+    const Level& l = levels[level];
+    buffers.drawTriangles(l.indexCount, l.firstIndex, (int)l.baseVertex, instanceCount);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// return the coarsest level whose edges project to <= maxEdgePixels, or the
+// finest level if none does
+///////////////////////////////////////////////////////////////////////////////
+int IcosphereLodChain::selectLevel(float projectedRadius) const
+{
+    int last = (int)levels.size() - 1;
+    for (int i = 0; i < last; ++i)
+    {
+        if (projectedRadius * EDGE_RATIO / levels[i].subdivision <= maxEdgePixels)
+            return i;
+    }
+    return last;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// same selection as camera distances for spheres of worldRadius:
+// level i is used from distances[i] on (the first level with distance >=
+// distances[i] wins, the finest level has 0)
+// fovY is in radians, viewportHeight in pixels
+///////////////////////////////////////////////////////////////////////////////
+void IcosphereLodChain::computeSwitchDistances(float worldRadius, float fovY, float viewportHeight,
+                                               std::vector<float>& distances) const
+{
+    // projected radius = worldRadius * pixelsPerUnit / distance
+    float pixelsPerUnit = viewportHeight * 0.5f / std::tan(fovY * 0.5f);
+
+    distances.resize(levels.size());
+    for (std::size_t i = 0; i < levels.size(); ++i)
+        distances[i] = worldRadius * pixelsPerUnit * EDGE_RATIO / (levels[i].subdivision * maxEdgePixels);
+    if (!distances.empty())
+        distances.back() = 0.0f;
+}
+
+float IcosphereLodChain::computeProjectedRadius(float worldRadius, float distance, float fovY, float viewportHeight)
+{
+    if (distance <= worldRadius)
+        return viewportHeight;              // camera inside or touching the sphere
+    return worldRadius * viewportHeight * 0.5f / (distance * std::tan(fovY * 0.5f));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// print itself
+///////////////////////////////////////////////////////////////////////////////
+void IcosphereLodChain::printSelf() const
+{
+    std::cout << "===== IcosphereLodChain =====\n"
+              << "         Radius: " << radius << "\n"
+              << " Smooth Shading: " << (smooth ? "true" : "false") << "\n"
+              << "    Vertex Size: " << interleavedStride << " bytes\n"
+              << "Max Edge Pixels: " << maxEdgePixels << "\n";
+    for (std::size_t i = 0; i < levels.size(); ++i)
+    {
+        std::cout << "        Level " << i << ": subdivision " << levels[i].subdivision
+                  << ", " << levels[i].vertexCount << " vertices, " << levels[i].indexCount / 3 << " triangles\n";
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// IcosphereLodChain.h
+// ===================
+// Levels of detail of an icosphere (e.g. subdivision 1, 2, 4, 8) packed into
+// one interleaved vertex buffer (V/N/T in an Icosphere::VertexFormat) and one
+// index buffer, so a single VBO/EBO serves every level. Each level keeps its
+// own local indices; after createBuffers(), drawLevel() draws a level from the
+// shared VAO with glDraw*BaseVertex(level.indexCount, level.firstIndex,
+// level.baseVertex).
+//
+// Levels found in the MeshCache are not copied: set() only reads their sizes,
+// and createBuffers() maps each blob again and uploads it straight into its
+// range of the VBO/EBO. Only generated levels are kept in memory until then.
+//
+// A level is chosen from the projected size of the sphere: the coarsest level
+// whose triangle edges stay under maxEdgePixels on screen. For a whole batch
+// of instances, computeSwitchDistances() turns this into per-level camera
+// distances so the per-instance test is a single compare per level.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GEOMETRY_ICOSPHERE_LOD_CHAIN_H
+#define GEOMETRY_ICOSPHERE_LOD_CHAIN_H
+
+#include <vector>
+#include "Icosphere.h"
+#include "IcosphereBuffers.h"
+
+class MeshCache;
+class JobSystem;
+
+class IcosphereLodChain
+{
+public:
+    struct Level
+    {
+        int subdivision;
+        unsigned int baseVertex;            // first vertex of the level in the vertex array
+        unsigned int vertexCount;
+        unsigned int firstIndex;            // first index of the level in the index array
+        unsigned int indexCount;
+    };
+
+    // ctor/dtor
+    IcosphereLodChain(float radius = 1.0f, const std::vector<int>& subdivisions = { 1, 2, 4, 8 }, bool smooth = true,
+                      Icosphere::VertexFormat format = Icosphere::VERTEX_FORMAT_FLOAT, MeshCache* cache = 0,
+                      JobSystem* jobs = 0);
+    ~IcosphereLodChain() {}
+    IcosphereLodChain(const IcosphereLodChain&) = delete;
+    IcosphereLodChain& operator=(const IcosphereLodChain&) = delete;
+
+    // getters/setters
+    void set(float radius, const std::vector<int>& subdivisions, bool smooth,
+             Icosphere::VertexFormat format = Icosphere::VERTEX_FORMAT_FLOAT, MeshCache* cache = 0,
+             JobSystem* jobs = 0);  // levels are loaded from/saved to the cache if given (it must outlive createBuffers()),
+                                   // generated on the jobs if given
+    int getCacheHits() const { return cacheHits; }          // # of levels loaded from the cache by the last set()
+    float getRadius() const { return radius; }
+    bool getSmooth() const { return smooth; }
+    Icosphere::VertexFormat getVertexFormat() const { return vertexFormat; }
+    float getMaxEdgePixels() const { return maxEdgePixels; }
+    void setMaxEdgePixels(float pixels);                    // target on-screen length of a triangle edge
+
+    int getLevelCount() const { return (int)levels.size(); }     // coarsest first
+    const Level& getLevel(int level) const { return levels[level]; }
+
+    // packed buffers of all levels
+    unsigned int getInterleavedVertexCount() const { return vertexCount; }
+    unsigned int getInterleavedVertexSize() const { return vertexCount * interleavedStride; }    // # of bytes
+    int getInterleavedStride() const { return interleavedStride; }
+    const Icosphere::VertexAttrib& getInterleavedAttrib(int attrib) const { return interleavedAttribs[attrib]; }
+    unsigned int getIndexCount() const { return indexCount; }
+    unsigned int getIndexSize() const { return indexCount * sizeof(unsigned int); }
+
+    // GPU buffers of all levels (GL context must be current); call createBuffers() again after set()
+    void createBuffers();
+    void releaseBuffers() { buffers.release(); }
+    const IcosphereBuffers& getBuffers() const { return buffers; }
+    void drawLevel(int level, int instanceCount = 1) const;
+
+    // level selection
+    int selectLevel(float projectedRadius) const;           // radius on screen in pixels
+    void computeSwitchDistances(float worldRadius, float fovY, float viewportHeight, std::vector<float>& distances) const;
+    static float computeProjectedRadius(float worldRadius, float distance, float fovY, float viewportHeight);
+
+    // debug
+    void printSelf() const;
+
+private:
+    // where createBuffers() finds the data of a level
+    struct LevelSource
+    {
+        bool cached;                        // in the cache blob of the level, else in the generated arrays
+        std::size_t vertexOffset;           // # of bytes into generatedVertices
+        std::size_t indexOffset;            // # of indices into generatedIndices
+    };
+
+    void appendLevel(int subdivision, unsigned int vertexCount, int stride, const Icosphere::VertexAttrib* attribs,
+                     unsigned int indexCount, bool cached);
+    void uploadLevel(int level, const void* vertexData, const unsigned int* levelIndices);
+
+    float radius;
+    bool smooth;
+    Icosphere::VertexFormat vertexFormat;
+    float maxEdgePixels;
+    std::vector<Level> levels;
+    std::vector<LevelSource> sources;
+    unsigned int vertexCount;               // all levels
+    unsigned int indexCount;
+    int interleavedStride;
+    Icosphere::VertexAttrib interleavedAttribs[Icosphere::ATTRIB_COUNT];
+    std::vector<unsigned char> generatedVertices;   // levels that were not in the cache, back to back
+    std::vector<unsigned int> generatedIndices;
+    MeshCache* cache;                       // not owned
+    int cacheHits;
+    IcosphereBuffers buffers;
+};
+
+#endif
@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////////
+// IcosphereTessellator.cpp
+// ========================
+// GPU backend for smooth icospheres: icosahedron patches subdivided by the
+// tessellation shaders.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "IcosphereTessellator.h"
+#include "Icosphere.h"
+
+// 20 faces of the icosahedron, in the order and winding of Icosphere::buildVerticesFlat()
+const unsigned int ICOSAHEDRON_INDICES[60] =
+{
+    0, 1, 2,    1, 6, 2,    2, 6, 7,    6, 11, 7,
+    0, 2, 3,    2, 7, 3,    3, 7, 8,    7, 11, 8,
+    0, 3, 4,    3, 8, 4,    4, 8, 9,    8, 11, 9,
+    0, 4, 5,    4, 9, 5,    5, 9, 10,   9, 11, 10,
+    0, 5, 1,    5, 10, 1,   1, 10, 6,   10, 11, 6
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+IcosphereTessellator::IcosphereTessellator() : vao(0), vbo(0), ebo(0), maxLevel(64), fixedLevel(0),
+                                               maxEdgePixels(8.0f), pixelsPerUnit(1.0f)
+{
+    for (int i = 0; i < LEVEL_UNIFORM_COUNT; ++i)
+        levelLocations[i] = -1;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// tessellation shaders are core in GL 4.0; a glad built for 3.3 has no entry
+// points for them, the backend is then never available
+///////////////////////////////////////////////////////////////////////////////
+bool IcosphereTessellator::isSupported()
+{
+#ifdef GL_VERSION_4_0
+    return GLAD_GL_VERSION_4_0 != 0;
+#else
+    return false;
+#endif
+}
+
+unsigned int IcosphereTessellator::getMemorySize()
+{
+    return 12 * 3 * sizeof(float) + sizeof(ICOSAHEDRON_INDICES);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// link the 4 stages and upload the unit icosahedron; false (and nothing
+// created) if the context has no tessellation or a stage fails
+///////////////////////////////////////////////////////////////////////////////
+bool IcosphereTessellator::create(const char* vertexPath, const char* controlPath, const char* evaluationPath,
+                                  const char* fragmentPath)
+{
+#ifdef GL_VERSION_4_0
+    if (!isSupported())
+        return false;
+    release();
+
+    shader.reset(new CachedShader(vertexPath, fragmentPath, nullptr, controlPath, evaluationPath));
+    if (!shader->linked)
+    {
+        release();
+        return false;
+    }
+    levelLocations[MAX_EDGE_PIXELS] = shader->location("maxEdgePixels");
+    levelLocations[PIXELS_PER_UNIT] = shader->location("pixelsPerUnit");
+    levelLocations[MAX_LEVEL] = shader->location("maxLevel");
+    levelLocations[FIXED_LEVEL] = shader->location("fixedLevel");
+
+    glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &maxLevel);
+
+    // unit icosahedron, 3-vertex patches
+    std::vector<float> corners = Icosphere(1.0f, 1, false).computeIcosahedronVertices();
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(float), corners.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(ICOSAHEDRON_INDICES), ICOSAHEDRON_INDICES, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void IcosphereTessellator::release()
+{
+    if (shader)
+        shader->release();
+    shader.reset();
+    if (vao)
+    {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+    }
+    vao = vbo = ebo = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setters
+///////////////////////////////////////////////////////////////////////////////
+void IcosphereTessellator::setMaxEdgePixels(float pixels)
+{
+    maxEdgePixels = std::max(pixels, 0.5f);
+}
+
+void IcosphereTessellator::setProjection(float fovY, float viewportHeight)
+{
+    pixelsPerUnit = viewportHeight / (2.0f * tanf(fovY * 0.5f));
+}
+
+void IcosphereTessellator::use() const
+{
+    shader->use();
+    shader->setFloat(levelLocations[MAX_EDGE_PIXELS], maxEdgePixels);
+    shader->setFloat(levelLocations[PIXELS_PER_UNIT], pixelsPerUnit);
+    shader->setFloat(levelLocations[MAX_LEVEL], (float)maxLevel);
+    shader->setFloat(levelLocations[FIXED_LEVEL], (float)fixedLevel);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw instanceCount spheres, the program must be in use
+///////////////////////////////////////////////////////////////////////////////
+void IcosphereTessellator::draw(int instanceCount) const
+{
+#ifdef GL_VERSION_4_0
+    if (!vao || instanceCount <= 0)
+        return;
+
+    glBindVertexArray(vao);
+    glPatchParameteri(GL_PATCH_VERTICES, 3);
+    if (instanceCount == 1)
+        glDrawElements(GL_PATCHES, 60, GL_UNSIGNED_INT, 0);
+    else
+        glDrawElementsInstanced(GL_PATCHES, 60, GL_UNSIGNED_INT, 0, instanceCount);
+#endif
+}
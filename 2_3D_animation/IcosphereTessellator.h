@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+// IcosphereTessellator.h
+// ======================
+// GPU backend for smooth icospheres (GL 4.0): only the 12 vertices and 20
+// triangles of the icosahedron are uploaded, as 3-vertex patches, and the
+// tessellation shaders subdivide each face and push the new vertices out to
+// the sphere. Memory stays at 384 bytes for any subdivision, instead of
+// growing with N^2 like the CPU mesh.
+//
+// The level is picked per instance in the control shader, from the projected
+// size of the sphere (the same rule as IcosphereLodChain::selectLevel()), or
+// fixed for every instance with setFixedLevel(). All 20 patches of a sphere
+// get the same integer level N, so the shared edges match (no cracks). Level N
+// splits the edges into N segments like an Icosphere of subdivision N, but the
+// inside of a face follows the GL triangle pattern (concentric rings, 1.5x the
+// triangles of subdivision N). N is capped at GL_MAX_TESS_GEN_LEVEL (>= 64).
+//
+// Attrib locations: 0 icosahedron corner (unit radius); a per-instance offset
+// may be added at 3 by the caller (bind getVao() first). The radius is the
+// scale of the model matrix.
+//
+// isSupported() needs a current GL 4.0 context; without one (3.3 core), the
+// caller keeps the CPU mesh (Icosphere/IcosphereLodChain). Like the other GL
+// classes, release() must be called while the context is current.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GEOMETRY_ICOSPHERE_TESSELLATOR_H
+#define GEOMETRY_ICOSPHERE_TESSELLATOR_H
+
+#include <memory>
+#include "../common/shader_cached.h"
+
+class IcosphereTessellator
+{
+public:
+    // ctor/dtor
+    IcosphereTessellator();
+    ~IcosphereTessellator() {}
+    IcosphereTessellator(const IcosphereTessellator&) = delete;
+    IcosphereTessellator& operator=(const IcosphereTessellator&) = delete;
+
+    static bool isSupported();                              // GL 4.0 with tessellation shaders
+
+    // build the program (vertex, tess control, tess evaluation, fragment) and the patch buffers
+    bool create(const char* vertexPath, const char* controlPath, const char* evaluationPath, const char* fragmentPath);
+    void release();
+    bool isCreated() const { return vao != 0; }
+
+    const CachedShader& getShader() const { return *shader; }   // valid after create() succeeded
+    unsigned int getProgram() const { return shader ? shader->ID : 0; }
+    unsigned int getVao() const { return vao; }
+    int getMaxLevel() const { return maxLevel; }
+    static unsigned int getMemorySize();                    // # of bytes of vertex + index data
+
+    // level selection, uploaded by use()
+    void setMaxEdgePixels(float pixels);                    // target on-screen length of a triangle edge
+    float getMaxEdgePixels() const { return maxEdgePixels; }
+    void setFixedLevel(int level) { fixedLevel = level; }   // > 0: same level for every instance, 0: by projected size
+    int getFixedLevel() const { return fixedLevel; }
+    void setProjection(float fovY, float viewportHeight);   // fovY in radians, viewportHeight in pixels
+
+    // bind the program and upload the level uniforms; other uniforms through getShader()
+    void use() const;
+
+    void draw(int instanceCount = 1) const;                 // 20 patches per sphere
+
+private:
+    // level uniforms, resolved once by create()
+    enum LevelUniform { MAX_EDGE_PIXELS, PIXELS_PER_UNIT, MAX_LEVEL, FIXED_LEVEL, LEVEL_UNIFORM_COUNT };
+
+    std::unique_ptr<CachedShader> shader;
+    int levelLocations[LEVEL_UNIFORM_COUNT];
+    unsigned int vao;
+    unsigned int vbo;
+    unsigned int ebo;
+    int maxLevel;
+    int fixedLevel;
+    float maxEdgePixels;
+    float pixelsPerUnit;                    // viewportHeight / (2 * tan(fovY / 2))
+};
+
+#endif
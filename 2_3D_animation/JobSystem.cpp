@@ -0,0 +1,194 @@
+///////////////////////////////////////////////////////////////////////////////
+// JobSystem.cpp
+// =============
+// Small work-stealing thread pool for per-frame simulation work.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor: start the worker threads
+///////////////////////////////////////////////////////////////////////////////
+JobSystem::JobSystem(unsigned int workerCount)
+{
+    for (unsigned int i = 0; i < workerCount; ++i)
+        queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+    for (unsigned int i = 0; i < workerCount; ++i)
+        workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dtor: workers finish the tiles already queued, then exit
+///////////////////////////////////////////////////////////////////////////////
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// one worker per spare hardware thread
+///////////////////////////////////////////////////////////////////////////////
+unsigned int JobSystem::getDefaultWorkerCount()
+{
+    unsigned int threads = std::thread::hardware_concurrency();
+    return threads > 1 ? threads - 1 : 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// split [0, count) into tiles and distribute them round-robin
+///////////////////////////////////////////////////////////////////////////////
+void JobSystem::parallelFor(std::size_t count, std::size_t grain, const RangeFunc& func, Fence& fence)
+{
+    if (count == 0)
+        return;
+    if (grain == 0)
+        grain = 1;
+
+    // nothing to share: run it here
+    if (workers.empty() || count <= grain)
+    {
+        func(0, count);
+        return;
+    }
+
+    std::size_t tileCount = (count + grain - 1) / grain;
+    std::shared_ptr<RangeFunc> shared = std::make_shared<RangeFunc>(func);
+    fence.pending.fetch_add((int)tileCount, std::memory_order_relaxed);
+
+    for (std::size_t begin = 0; begin < count; begin += grain)
+    {
+        Job job = { shared, begin, begin + grain < count ? begin + grain : count, &fence };
+        WorkerQueue& queue = *queues[nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(job);
+        }
+        queuedJobs.fetch_add(1, std::memory_order_release);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);     // pairs with the sleep predicate
+    }
+    wakeUp.notify_all();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// wait for a fence; the calling thread steals tiles instead of idling, and
+// once none are left to steal sleeps until a fence completes (the tiles still
+// pending are running on workers)
+///////////////////////////////////////////////////////////////////////////////
+void JobSystem::wait(Fence& fence)
+{
+    Job job;
+    unsigned int thief = (unsigned int)queues.size();      // not a worker: steals from every queue
+    while (!fence.isDone())
+    {
+        if (steal(thief, job))
+        {
+            run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(doneMutex);
+        fenceDone.wait(lock, [this, &fence]() { return fence.isDone() || queuedJobs.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// worker: drain own deque, then steal, then sleep until new tiles arrive
+///////////////////////////////////////////////////////////////////////////////
+void JobSystem::workerLoop(unsigned int index)
+{
+    Job job;
+    while (true)
+    {
+        if (popOwn(index, job) || steal(index, job))
+        {
+            run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stopping || queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (stopping && queuedJobs.load(std::memory_order_acquire) == 0)
+            return;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// take the newest tile from the own deque (LIFO, cache warm)
+///////////////////////////////////////////////////////////////////////////////
+bool JobSystem::popOwn(unsigned int index, Job& job)
+{
+    WorkerQueue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+        return false;
+    job = queue.jobs.back();
+    queue.jobs.pop_back();
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// take the oldest tile from another deque (FIFO end)
+///////////////////////////////////////////////////////////////////////////////
+bool JobSystem::steal(unsigned int thief, Job& job)
+{
+    std::size_t count = queues.size();
+    for (std::size_t i = 1; i <= count; ++i)
+    {
+        std::size_t victim = (thief + i) % count;
+        if (victim == thief)
+            continue;
+        WorkerQueue& queue = *queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty())
+            continue;
+        job = queue.jobs.front();
+        queue.jobs.pop_front();
+        queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// run a tile and signal its fence; the last tile wakes the waiting threads
+///////////////////////////////////////////////////////////////////////////////
+void JobSystem::run(Job& job)
+{
+    (*job.func)(job.begin, job.end);
+    job.func.reset();
+    if (job.fence->pending.fetch_sub(1, std::memory_order_release) == 1)
+    {
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);    // pairs with the wait predicate
+        }
+        fenceDone.notify_all();
+    }
+}
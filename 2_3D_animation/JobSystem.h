@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+// JobSystem.h
+// ===========
+// Small work-stealing thread pool for per-frame simulation work.
+// parallelFor() splits an index range into tiles and queues them round-robin
+// on the worker deques. Each worker pops from the back of its own deque and
+// steals from the front of the others when it runs dry. A Fence counts the
+// outstanding tiles; wait() lets the calling (render) thread run tiles too
+// until the fence drops to zero, then sleeps until the last tile of the fence
+// completes on a worker. parallelFor() and wait() may be called from any
+// number of threads at once.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem
+{
+public:
+    // completion fence for a group of tiles
+    struct Fence
+    {
+        std::atomic<int> pending{ 0 };
+        bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+    };
+
+    // tile body, called with [begin, end)
+    typedef std::function<void(std::size_t begin, std::size_t end)> RangeFunc;
+
+    // ctor/dtor
+    // workerCount = 0 runs everything inline on the calling thread
+    explicit JobSystem(unsigned int workerCount = getDefaultWorkerCount());
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned int getWorkerCount() const { return (unsigned int)workers.size(); }
+    static unsigned int getDefaultWorkerCount();    // hardware threads - 1 (the render thread helps)
+
+    // split [0, count) into tiles of at most grain items and queue them
+    // a range that fits in a single tile runs inline before returning
+    void parallelFor(std::size_t count, std::size_t grain, const RangeFunc& func, Fence& fence);
+
+    // block until the fence is done, running queued tiles meanwhile
+    void wait(Fence& fence);
+
+private:
+    struct Job
+    {
+        std::shared_ptr<RangeFunc> func;
+        std::size_t begin;
+        std::size_t end;
+        Fence* fence;
+    };
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void workerLoop(unsigned int index);
+    bool popOwn(unsigned int index, Job& job);
+    bool steal(unsigned int thief, Job& job);
+    void run(Job& job);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::atomic<int> queuedJobs{ 0 };
+    std::atomic<bool> stopping{ false };
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::mutex doneMutex;
+    std::condition_variable fenceDone;      // some fence dropped to zero
+    std::atomic<unsigned int> nextQueue{ 0 };
+};
+
+#endif
@@ -0,0 +1,345 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshCache.cpp
+// =============
+// On-disk cache of generated Icosphere data, memory-mapped on a hit.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "MeshCache.h"
+
+// arrays in the blob start on this alignment (attrib fetch and SIMD friendly)
+const std::size_t BLOB_ALIGNMENT = 16;
+
+namespace
+{
+    std::uint64_t alignUp(std::uint64_t value)
+    {
+        return (value + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+    }
+
+    bool makeDirectory(const std::string& path)
+    {
+#ifdef _WIN32
+        return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+        return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+MeshCache::MeshCache(const std::string& directory)
+    : directory(directory), mappedData(0), mappedSize(0), header(0)
+#ifdef _WIN32
+    , fileHandle(0), mappingHandle(0)
+#endif
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dtor
+///////////////////////////////////////////////////////////////////////////////
+MeshCache::~MeshCache()
+{
+    close();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// file of a key: the radius is written as its bit pattern, so every float
+// value gets its own file without rounding in the name
+///////////////////////////////////////////////////////////////////////////////
+std::string MeshCache::getPath(float radius, int subdivision, bool smooth, Icosphere::VertexFormat format,
+                               bool optimized) const
+{
+    std::uint32_t radiusBits;
+    std::memcpy(&radiusBits, &radius, 4);
+
+    char name[128];
+    std::snprintf(name, sizeof(name), "icosphere_r%08x_s%d_%s_f%d%s.bin", radiusBits, subdivision,
+                  smooth ? "smooth" : "flat", (int)format, optimized ? "_opt" : "");
+    return directory + "/" + name;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// map the blob of the key and validate it; any mismatch is a miss
+///////////////////////////////////////////////////////////////////////////////
+bool MeshCache::open(float radius, int subdivision, bool smooth, Icosphere::VertexFormat format, bool optimized)
+{
+    close();
+    if (!mapFile(getPath(radius, subdivision, smooth, format, optimized)))
+        return false;
+
+    const Header* h = (const Header*)mappedData;
+    bool valid = mappedSize >= sizeof(Header) &&
+                 std::memcmp(h->magic, "ICOM", 4) == 0 &&
+                 h->version == VERSION &&
+                 h->headerSize == sizeof(Header) &&
+                 h->fileSize == mappedSize &&
+                 h->radius == radius && h->subdivision == subdivision &&
+                 h->smooth == (smooth ? 1u : 0u) && h->vertexFormat == (std::uint32_t)format &&
+                 h->optimized == (optimized ? 1u : 0u) &&
+                 h->vertexOffset + (std::uint64_t)h->vertexCount * h->stride <= mappedSize &&
+                 h->indexOffset + (std::uint64_t)h->indexCount * sizeof(unsigned int) <= mappedSize &&
+                 h->lineIndexOffset + (std::uint64_t)h->lineIndexCount * sizeof(unsigned int) <= mappedSize &&
+                 h->stride == (format == Icosphere::VERTEX_FORMAT_PACKED ? 16u : 32u) &&
+                 h->checksum == computeBlobChecksum(*h, mappedData, mappedSize);
+    if (!valid)
+    {
+        close();
+        return false;
+    }
+
+    header = h;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// write header + arrays to a temp file, then rename it over the old blob, so
+// a reader never maps a half-written file
+///////////////////////////////////////////////////////////////////////////////
+bool MeshCache::save(const Icosphere& sphere, bool optimized) const
+{
+    if (!makeDirectory(directory))
+        return false;
+
+    Header h;
+    std::memset(&h, 0, sizeof(h));          // padding bytes too, equal spheres give equal files
+    std::memcpy(h.magic, "ICOM", 4);
+    h.version = VERSION;
+    h.headerSize = sizeof(Header);
+    h.radius = sphere.getRadius();
+    h.subdivision = sphere.getSubdivision();
+    h.smooth = sphere.getSmooth() ? 1 : 0;
+    h.vertexFormat = (std::uint32_t)sphere.getVertexFormat();
+    h.optimized = optimized ? 1 : 0;
+    h.stride = sphere.getInterleavedStride();
+    for (int i = 0; i < Icosphere::ATTRIB_COUNT; ++i)
+        h.attribs[i] = sphere.getInterleavedAttrib(i);
+    h.vertexCount = sphere.getInterleavedVertexCount();
+    h.indexCount = sphere.getIndexCount();
+    h.lineIndexCount = sphere.getLineIndexCount();
+    h.vertexOffset = alignUp(sizeof(Header));
+    h.indexOffset = alignUp(h.vertexOffset + sphere.getInterleavedVertexSize());
+    h.lineIndexOffset = alignUp(h.indexOffset + sphere.getIndexSize());
+    h.fileSize = alignUp(h.lineIndexOffset + sphere.getLineIndexSize());
+
+    // whole file in memory: header, arrays, zero padding
+    std::vector<unsigned char> blob((std::size_t)h.fileSize, 0);
+    std::memcpy(&blob[h.vertexOffset], sphere.getInterleavedVertices(), sphere.getInterleavedVertexSize());
+    std::memcpy(&blob[h.indexOffset], sphere.getIndices(), sphere.getIndexSize());
+    std::memcpy(&blob[h.lineIndexOffset], sphere.getLineIndices(), sphere.getLineIndexSize());
+    h.checksum = computeBlobChecksum(h, blob.data(), blob.size());
+    std::memcpy(&blob[0], &h, sizeof(Header));
+
+    std::string path = getPath(h.radius, h.subdivision, h.smooth != 0, sphere.getVertexFormat(), optimized);
+    std::string tmpPath = path + ".tmp";
+    std::FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file)
+        return false;
+    bool written = std::fwrite(blob.data(), 1, blob.size(), file) == blob.size();
+    written = std::fclose(file) == 0 && written;
+    if (!written)
+    {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    return MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// read-only mapping of the whole file
+///////////////////////////////////////////////////////////////////////////////
+bool MeshCache::mapFile(const std::string& path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!data)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    mappedData = (const unsigned char*)data;
+    mappedSize = (std::size_t)size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(0, (std::size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);                            // the mapping keeps the file alive
+    if (data == MAP_FAILED)
+        return false;
+    mappedData = (const unsigned char*)data;
+    mappedSize = (std::size_t)info.st_size;
+#endif
+    return true;
+}
+
+void MeshCache::close()
+{
+    if (!mappedData)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(mappedData);
+    CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+    mappingHandle = fileHandle = 0;
+#else
+    munmap((void*)mappedData, mappedSize);
+#endif
+    mappedData = 0;
+    mappedSize = 0;
+    header = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// getters of the mapped arrays
+///////////////////////////////////////////////////////////////////////////////
+unsigned int MeshCache::getInterleavedVertexCount() const
+{
+    return header ? header->vertexCount : 0;
+}
+
+unsigned int MeshCache::getInterleavedVertexSize() const
+{
+    return header ? header->vertexCount * header->stride : 0;
+}
+
+int MeshCache::getInterleavedStride() const
+{
+    return header ? (int)header->stride : 0;
+}
+
+const void* MeshCache::getInterleavedVertices() const
+{
+    return header ? mappedData + header->vertexOffset : 0;
+}
+
+const Icosphere::VertexAttrib& MeshCache::getInterleavedAttrib(int attrib) const
+{
+    return header->attribs[attrib];
+}
+
+unsigned int MeshCache::getIndexCount() const
+{
+    return header ? header->indexCount : 0;
+}
+
+const unsigned int* MeshCache::getIndices() const
+{
+    return header ? (const unsigned int*)(mappedData + header->indexOffset) : 0;
+}
+
+unsigned int MeshCache::getLineIndexCount() const
+{
+    return header ? header->lineIndexCount : 0;
+}
+
+const unsigned int* MeshCache::getLineIndices() const
+{
+    return header ? (const unsigned int*)(mappedData + header->lineIndexOffset) : 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// checksum of a whole blob: the header with its checksum field zeroed, then
+// everything after it, so the stride and attrib descriptors handed to
+// glVertexAttribPointer() are covered as well as the arrays
+///////////////////////////////////////////////////////////////////////////////
+std::uint64_t MeshCache::computeBlobChecksum(const Header& header, const unsigned char* blob, std::size_t size)
+{
+    Header h;
+    std::memcpy(&h, &header, sizeof(Header));  // padding bytes included
+    h.checksum = 0;
+    std::uint64_t hash = computeChecksum(&h, sizeof(Header));
+    return computeChecksum(blob + sizeof(Header), size - sizeof(Header), hash);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// 64-bit FNV-1a over 8-byte words in 4 interleaved lanes (the lanes hide the
+// multiply latency, ~8x the speed of the byte-wise hash), then the tail bytes;
+// pass the previous result as hash to continue over more data
+///////////////////////////////////////////////////////////////////////////////
+std::uint64_t MeshCache::computeChecksum(const void* data, std::size_t size, std::uint64_t hash)
+{
+    const std::uint64_t FNV_PRIME = 1099511628211ULL;
+    const unsigned char* bytes = (const unsigned char*)data;
+
+    std::uint64_t lanes[4] = { hash, hash ^ 1, hash ^ 2, hash ^ 3 };
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, bytes + i + j * 8, 8);
+            lanes[j] = (lanes[j] ^ word) * FNV_PRIME;
+        }
+    }
+    for (int j = 0; j < 4; ++j)
+        hash = (hash ^ lanes[j]) * FNV_PRIME;
+
+    for (; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshCache.h
+// ===========
+// On-disk cache of generated Icosphere data, one binary blob per key
+// (radius, subdivision, smooth, vertex format, cache-optimized). A blob is a
+// fixed header followed by the interleaved vertices, the indices and the line
+// indices, each 16-byte aligned, so a hit is memory-mapped and the arrays are
+// handed to glBufferData() as they are, without parsing.
+//
+// The header carries a magic, a format version and a checksum of the whole
+// file, header included (FNV-1a over 8-byte words); a blob from another
+// version, of another key, with a stride that does not match its vertex
+// format or with a bad checksum is a miss (and is overwritten by the next
+// save).
+//
+// usage:
+//     MeshCache cache("mesh_cache");
+//     if (!cache.open(radius, sub, true, format, true))
+//     {
+//         Icosphere sphere(radius, sub, true, format);
+//         sphere.optimizeVertexCache();
+//         cache.save(sphere, true);
+//         cache.open(radius, sub, true, format, true);
+//     }
+//     glBufferData(GL_ARRAY_BUFFER, cache.getInterleavedVertexSize(), cache.getInterleavedVertices(), ...);
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "Icosphere.h"
+
+class MeshCache
+{
+public:
+    static const std::uint32_t VERSION = 2;     // bump when the blob layout or the generator output changes
+
+    // ctor/dtor
+    explicit MeshCache(const std::string& directory = "mesh_cache");
+    ~MeshCache();
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    // map the blob of the key (read-only), false on a miss
+    bool open(float radius, int subdivision, bool smooth, Icosphere::VertexFormat format, bool optimized);
+    void close();                                           // unmap
+    bool isOpen() const { return mappedData != 0; }
+
+    // write the blob of the sphere (replaces the file atomically)
+    bool save(const Icosphere& sphere, bool optimized) const;
+
+    // mapped data, valid while open
+    unsigned int getInterleavedVertexCount() const;
+    unsigned int getInterleavedVertexSize() const;          // # of bytes
+    int getInterleavedStride() const;
+    const void* getInterleavedVertices() const;
+    const Icosphere::VertexAttrib& getInterleavedAttrib(int attrib) const;
+    unsigned int getIndexCount() const;
+    const unsigned int* getIndices() const;
+    unsigned int getLineIndexCount() const;
+    const unsigned int* getLineIndices() const;
+
+    const std::string& getDirectory() const { return directory; }
+    std::string getPath(float radius, int subdivision, bool smooth, Icosphere::VertexFormat format, bool optimized) const;
+
+    static std::uint64_t computeChecksum(const void* data, std::size_t size, std::uint64_t hash = 14695981039346656037ULL);
+
+private:
+    // file header, followed by the 3 arrays at the given offsets
+    struct Header
+    {
+        char magic[4];                                      // "ICOM"
+        std::uint32_t version;
+        std::uint32_t headerSize;                           // sizeof(Header)
+        float radius;
+        std::int32_t subdivision;
+        std::uint32_t smooth;
+        std::uint32_t vertexFormat;
+        std::uint32_t optimized;
+        std::uint32_t stride;
+        Icosphere::VertexAttrib attribs[Icosphere::ATTRIB_COUNT];
+        std::uint32_t vertexCount;
+        std::uint32_t indexCount;
+        std::uint32_t lineIndexCount;
+        std::uint64_t vertexOffset;                         // # of bytes from the start of the file
+        std::uint64_t indexOffset;
+        std::uint64_t lineIndexOffset;
+        std::uint64_t fileSize;
+        std::uint64_t checksum;                             // computeBlobChecksum(), this field taken as 0
+    };
+
+    bool mapFile(const std::string& path);
+    static std::uint64_t computeBlobChecksum(const Header& header, const unsigned char* blob, std::size_t size);
+
+    std::string directory;
+    const unsigned char* mappedData;
+    std::size_t mappedSize;
+    const Header* header;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+#endif
@@ -0,0 +1,372 @@
+///////////////////////////////////////////////////////////////////////////////
+// Profiler.cpp
+// ============
+// Frame profiler for the render loop: scoped CPU timers, GPU timer queries,
+// lock-free sample ring, CSV / Chrome trace export.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include "Profiler.h"
+
+namespace
+{
+    std::uint64_t steadyNs()
+    {
+        return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+Profiler::Profiler(std::size_t capacity, bool enabled)
+    : enabled(false), capacity(capacity < 16 ? 16 : capacity), head(0), frame(0),
+      origin(steadyNs()), gpuQueriesCreated(false), gpuActive(false), gpuDropped(0)
+{
+    for (int i = 0; i < GPU_LATENCY; ++i)
+    {
+        gpuFrames[i].count = 0;
+        gpuFrames[i].frame = 0;
+    }
+    setEnabled(enabled);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dtor
+///////////////////////////////////////////////////////////////////////////////
+Profiler::~Profiler()
+{
+    // GL queries are not deleted here, the context may already be gone (see releaseQueries())
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// enable/disable recording; the ring is allocated the first time it is enabled
+// so a disabled profiler costs no memory
+///////////////////////////////////////////////////////////////////////////////
+void Profiler::setEnabled(bool enabled)
+{
+    if (enabled && slots.empty())
+    {
+        slots = std::vector<Slot>(capacity);
+        for (std::size_t i = 0; i < slots.size(); ++i)
+            slots[i].seq.store(0, std::memory_order_relaxed);
+    }
+    this->enabled = enabled;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CPU scope
+///////////////////////////////////////////////////////////////////////////////
+Profiler::CpuScope::CpuScope(Profiler& profiler, const char* name)
+    : profiler(profiler), name(name), start(profiler.enabled ? profiler.now() : 0)
+{
+}
+
+Profiler::CpuScope::~CpuScope()
+{
+    if (profiler.enabled)
+        profiler.record(name, start, profiler.now() - start, KIND_CPU);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// start a new frame; GPU timers issued GPU_LATENCY frames ago are collected
+// and their query objects reused
+///////////////////////////////////////////////////////////////////////////////
+void Profiler::beginFrame()
+{
+    std::uint32_t next = frame.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (!enabled)
+        return;
+
+    GpuFrame& gpuFrame = gpuFrames[next % GPU_LATENCY];
+    if (gpuFrame.count > 0)
+        collectGpu(gpuFrame);
+    gpuFrame.frame = next;
+    gpuFrame.count = 0;
+}
+
+std::uint64_t Profiler::now() const
+{
+    return steadyNs() - origin;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// add a sample to the ring, safe from any thread
+// The slot is claimed with one atomic add; seq marks it complete so a reader
+// racing with a writer (or with a wrap-around) skips the slot instead of
+// reading a torn sample.
+///////////////////////////////////////////////////////////////////////////////
+void Profiler::record(const char* name, std::uint64_t start, std::uint64_t duration, Kind kind)
+{
+    if (!enabled)
+        return;
+
+    writeSlot(name, start, duration, frame.load(std::memory_order_relaxed), getThreadId(), kind);
+}
+
+void Profiler::writeSlot(const char* name, std::uint64_t start, std::uint64_t duration,
+                         std::uint32_t frame, std::uint32_t thread, Kind kind)
+{
+    std::uint64_t ticket = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[ticket % slots.size()];
+
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.duration.store(duration, std::memory_order_relaxed);
+    slot.frameThreadKind.store(((std::uint64_t)frame << 32) | ((std::uint64_t)thread << 1) | (std::uint64_t)kind,
+                               std::memory_order_relaxed);
+    slot.seq.store(ticket + 1, std::memory_order_release);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GPU timers, one GL_TIME_ELAPSED query per scope
+///////////////////////////////////////////////////////////////////////////////
+void Profiler::beginGpu(const char* name)
+{
+    if (!enabled || gpuActive)
+        return;
+
+    if (!gpuQueriesCreated)
+    {
+        for (int i = 0; i < GPU_LATENCY; ++i)
+            glGenQueries(MAX_GPU_SCOPES, gpuFrames[i].queries);
+        gpuQueriesCreated = true;
+    }
+
+    GpuFrame& gpuFrame = gpuFrames[frame.load(std::memory_order_relaxed) % GPU_LATENCY];
+    if (gpuFrame.count >= MAX_GPU_SCOPES)
+        return;
+
+    int index = gpuFrame.count++;
+    gpuFrame.names[index] = name;
+    gpuFrame.starts[index] = now();
+    glBeginQuery(GL_TIME_ELAPSED, gpuFrame.queries[index]);
+    gpuActive = true;
+}
+
+void Profiler::endGpu()
+{
+    if (!gpuActive)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    gpuActive = false;
+}
+
+// Results complete in submission order, so once one is not available the rest
+// of the frame is not either. Those timers are dropped (and counted) rather
+// than waited on; the query objects are reissued this frame regardless.
+void Profiler::collectGpu(GpuFrame& gpuFrame)
+{
+    for (int i = 0; i < gpuFrame.count; ++i)
+    {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(gpuFrame.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            gpuDropped += gpuFrame.count - i;
+            break;
+        }
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(gpuFrame.queries[i], GL_QUERY_RESULT, &elapsed);
+
+        writeSlot(gpuFrame.names[i], gpuFrame.starts[i], elapsed, gpuFrame.frame, 0, KIND_GPU);
+    }
+    gpuFrame.count = 0;
+}
+
+void Profiler::releaseQueries()
+{
+    if (!gpuQueriesCreated)
+        return;
+
+    if (gpuActive)
+        endGpu();
+    for (int i = 0; i < GPU_LATENCY; ++i)
+    {
+        glDeleteQueries(MAX_GPU_SCOPES, gpuFrames[i].queries);
+        gpuFrames[i].count = 0;
+    }
+    gpuQueriesCreated = false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// copy the complete samples out of the ring, oldest first
+///////////////////////////////////////////////////////////////////////////////
+std::vector<Profiler::Sample> Profiler::getSamples() const
+{
+    std::vector<Sample> samples;
+    if (slots.empty())
+        return samples;                     // never enabled
+
+    std::uint64_t end = head.load(std::memory_order_acquire);
+    std::uint64_t begin = end > slots.size() ? end - slots.size() : 0;
+    samples.reserve((std::size_t)(end - begin));
+
+    for (std::uint64_t ticket = begin; ticket < end; ++ticket)
+    {
+        const Slot& slot = slots[ticket % slots.size()];
+        if (slot.seq.load(std::memory_order_acquire) != ticket + 1)
+            continue;
+
+        Sample sample;
+        sample.name = slot.name.load(std::memory_order_relaxed);
+        sample.start = slot.start.load(std::memory_order_relaxed);
+        sample.duration = slot.duration.load(std::memory_order_relaxed);
+        std::uint64_t frameThreadKind = slot.frameThreadKind.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != ticket + 1)
+            continue;   // overwritten while copying
+
+        sample.frame = (std::uint32_t)(frameThreadKind >> 32);
+        sample.thread = (std::uint32_t)(frameThreadKind & 0xffffffff) >> 1;
+        sample.kind = (Kind)(frameThreadKind & 1);
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// average ms per frame for each pass over the last complete frames
+// CPU samples of the same name are summed within a frame (e.g. worker tiles).
+// GPU results arrive GPU_LATENCY frames late, so their window is shifted.
+///////////////////////////////////////////////////////////////////////////////
+std::string Profiler::getSummary(std::uint32_t frames) const
+{
+    std::uint32_t current = frame.load(std::memory_order_relaxed);
+    if (frames == 0 || current <= frames + GPU_LATENCY)
+        return std::string();
+
+    std::uint32_t cpuBegin = current - frames;
+    std::uint32_t gpuBegin = current - frames - GPU_LATENCY;
+
+    struct Entry
+    {
+        const char* name;
+        double cpu;
+        double gpu;
+        bool hasGpu;
+    };
+    std::vector<Entry> entries;
+
+    std::vector<Sample> samples = getSamples();
+    for (std::size_t i = 0; i < samples.size(); ++i)
+    {
+        const Sample& s = samples[i];
+        bool isGpu = s.kind == KIND_GPU;
+        std::uint32_t begin = isGpu ? gpuBegin : cpuBegin;
+        if (s.frame < begin || s.frame >= begin + frames)
+            continue;
+
+        std::size_t e = 0;
+        while (e < entries.size() && entries[e].name != s.name)
+            ++e;
+        if (e == entries.size())
+        {
+            Entry entry = { s.name, 0.0, 0.0, false };
+            entries.push_back(entry);
+        }
+        (isGpu ? entries[e].gpu : entries[e].cpu) += s.duration;
+        entries[e].hasGpu = entries[e].hasGpu || isGpu;
+    }
+
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    for (std::size_t e = 0; e < entries.size(); ++e)
+    {
+        if (e > 0)
+            ss << " | ";
+        ss << entries[e].name << " " << entries[e].cpu / frames * 1e-6;
+        if (entries[e].hasGpu)
+            ss << "/" << entries[e].gpu / frames * 1e-6 << " gpu";
+    }
+    return ss.str();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dump the ring as CSV: frame,kind,thread,name,start_us,duration_us
+///////////////////////////////////////////////////////////////////////////////
+bool Profiler::writeCsv(const char* path) const
+{
+    std::FILE* file = std::fopen(path, "w");
+    if (!file)
+        return false;
+
+    std::vector<Sample> samples = getSamples();
+    std::fprintf(file, "frame,kind,thread,name,start_us,duration_us\n");
+    for (std::size_t i = 0; i < samples.size(); ++i)
+    {
+        const Sample& s = samples[i];
+        std::fprintf(file, "%u,%s,%u,%s,%.3f,%.3f\n", s.frame, s.kind == KIND_GPU ? "gpu" : "cpu", s.thread,
+                     s.name, s.start * 1e-3, s.duration * 1e-3);
+    }
+    return std::fclose(file) == 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dump the ring as Chrome trace JSON (complete "X" events, times in us)
+// GPU samples go on their own track, placed at the CPU time they were issued.
+///////////////////////////////////////////////////////////////////////////////
+bool Profiler::writeChromeTrace(const char* path) const
+{
+    std::FILE* file = std::fopen(path, "w");
+    if (!file)
+        return false;
+
+    const unsigned int GPU_TRACK = 1000;
+    std::vector<Sample> samples = getSamples();
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}", GPU_TRACK);
+    for (std::size_t i = 0; i < samples.size(); ++i)
+    {
+        const Sample& s = samples[i];
+        bool isGpu = s.kind == KIND_GPU;
+        std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                           "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+                     s.name, isGpu ? "gpu" : "cpu", isGpu ? GPU_TRACK : s.thread,
+                     s.start * 1e-3, s.duration * 1e-3, s.frame);
+    }
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// small sequential id per recording thread
+///////////////////////////////////////////////////////////////////////////////
+std::uint32_t Profiler::getThreadId()
+{
+    static std::atomic<std::uint32_t> nextId(0);
+    thread_local std::uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+// Profiler.h
+// ==========
+// Frame profiler for the render loop: scoped CPU timers and GL_TIME_ELAPSED
+// GPU timers per pass. Samples go into a fixed-size lock-free ring (any
+// thread may record, e.g. the job system workers). The ring can be dumped
+// as CSV or as Chrome trace JSON (chrome://tracing, Perfetto), and a short
+// per-pass summary is available for an on-screen overlay.
+//
+// Cost when enabled: 2 clock reads and 1 atomic add per CPU scope, and no
+// allocation. GPU results are read 4 frames late and only if already
+// available, so the query never stalls; a timer still pending by then is
+// dropped (see getGpuDropped()).
+// When disabled every call returns immediately, and the ring is not allocated
+// until the first setEnabled(true) (call it from the GL thread between
+// frames, not while other threads may record).
+//
+// usage:
+//     profiler.beginFrame();
+//     {
+//         Profiler::CpuScope cpu(profiler, "sphere draw");
+//         Profiler::GpuScope gpu(profiler, "sphere draw");
+//         ...
+//     }
+//
+// Names must be string literals (or outlive the profiler); only the pointer
+// is stored. GPU scopes cannot nest (GL_TIME_ELAPSED limitation) and must be
+// issued on the GL thread.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class Profiler
+{
+public:
+    enum Kind
+    {
+        KIND_CPU,
+        KIND_GPU
+    };
+
+    struct Sample
+    {
+        const char* name;
+        std::uint64_t start;                // ns since the profiler was created
+        std::uint64_t duration;             // ns
+        std::uint32_t frame;
+        std::uint32_t thread;               // small per-thread id, 0 = first thread that recorded
+        Kind kind;
+    };
+
+    // scoped timers
+    class CpuScope
+    {
+    public:
+        CpuScope(Profiler& profiler, const char* name);
+        ~CpuScope();
+    private:
+        Profiler& profiler;
+        const char* name;
+        std::uint64_t start;
+    };
+
+    class GpuScope
+    {
+    public:
+        GpuScope(Profiler& profiler, const char* name) : profiler(profiler) { profiler.beginGpu(name); }
+        ~GpuScope() { profiler.endGpu(); }
+    private:
+        Profiler& profiler;
+    };
+
+    // ctor/dtor
+    explicit Profiler(std::size_t capacity = 1 << 16, bool enabled = true);
+    ~Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    void setEnabled(bool enabled);                          // allocates the ring on first enable
+    bool isEnabled() const { return enabled; }
+    std::uint32_t getFrame() const { return frame.load(std::memory_order_relaxed); }
+    std::uint64_t getGpuDropped() const { return gpuDropped; }    // GPU timers not ready GPU_LATENCY frames later
+
+    // per frame
+    void beginFrame();                                      // next frame + collect finished GPU timers
+    std::uint64_t now() const;                              // ns since the profiler was created
+    void record(const char* name, std::uint64_t start, std::uint64_t duration, Kind kind = KIND_CPU);
+    void beginGpu(const char* name);
+    void endGpu();
+
+    // reports
+    std::vector<Sample> getSamples() const;                 // oldest first, consistent entries only
+    std::string getSummary(std::uint32_t frames = 60) const;    // "solve 1.20 | draw 0.40/0.90 gpu ..." in ms per frame
+    bool writeCsv(const char* path) const;
+    bool writeChromeTrace(const char* path) const;
+    void releaseQueries();                                  // delete the GL queries while the context is current
+
+private:
+    // ring slot; seq = ticket + 1 once the sample is complete (seqlock, readers skip torn slots)
+    struct Slot
+    {
+        std::atomic<std::uint64_t> seq;
+        std::atomic<const char*> name;
+        std::atomic<std::uint64_t> start;
+        std::atomic<std::uint64_t> duration;
+        std::atomic<std::uint64_t> frameThreadKind;     // frame << 32 | thread << 1 | kind
+    };
+
+    // GPU queries are recycled every GPU_LATENCY frames
+    static const int GPU_LATENCY = 4;
+    static const int MAX_GPU_SCOPES = 16;               // per frame
+    struct GpuFrame
+    {
+        GLuint queries[MAX_GPU_SCOPES];
+        const char* names[MAX_GPU_SCOPES];
+        std::uint64_t starts[MAX_GPU_SCOPES];           // CPU time at issue, to place the sample in the trace
+        std::uint32_t frame;
+        int count;
+    };
+
+    void writeSlot(const char* name, std::uint64_t start, std::uint64_t duration,
+                   std::uint32_t frame, std::uint32_t thread, Kind kind);
+    void collectGpu(GpuFrame& gpuFrame);
+    static std::uint32_t getThreadId();
+
+    bool enabled;
+    std::size_t capacity;                               // slots, allocated on first enable
+    std::vector<Slot> slots;
+    std::atomic<std::uint64_t> head;                    // next ticket
+    std::atomic<std::uint32_t> frame;
+    std::uint64_t origin;                               // steady clock at creation, ns
+    GpuFrame gpuFrames[GPU_LATENCY];
+    bool gpuQueriesCreated;
+    bool gpuActive;
+    std::uint64_t gpuDropped;
+};
+
+#endif
@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////////////////
+// StreamingBuffer.cpp
+// ===================
+// Ring buffer for dynamic vertex data that is rewritten every frame.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StreamingBuffer.h"
+
+// region alignment, keeps every frame offset valid for any vertex attribute type
+const std::size_t REGION_ALIGNMENT = 256;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+StreamingBuffer::StreamingBuffer(std::size_t frameSize, int frameCount, Mode mode)
+    : id(0), mode(MODE_MAP_RANGE), frameSize(0), frameCount(frameCount < 1 ? 1 : frameCount),
+      current(0), writtenSize(0), mappedPtr(0)
+{
+    if (mode == MODE_AUTO)
+        this->mode = isModeSupported(MODE_PERSISTENT) ? MODE_PERSISTENT : MODE_MAP_RANGE;
+    else if (isModeSupported(mode))
+        this->mode = mode;
+
+    if (frameSize > 0)
+        resize(frameSize);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dtor
+// the GL objects are not deleted here (the context may be gone already), call
+// release() while the context is current
+///////////////////////////////////////////////////////////////////////////////
+StreamingBuffer::~StreamingBuffer()
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setters
+///////////////////////////////////////////////////////////////////////////////
+void StreamingBuffer::resize(std::size_t frameSize)
+{
+    frameSize = (frameSize + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT;
+    if (frameSize == this->frameSize && id)
+        return;
+
+    deleteStorage();
+    this->frameSize = frameSize;
+    createStorage();
+}
+
+void StreamingBuffer::setMode(Mode mode)
+{
+    if (mode == MODE_AUTO)
+        mode = isModeSupported(MODE_PERSISTENT) ? MODE_PERSISTENT : MODE_MAP_RANGE;
+    if (!isModeSupported(mode) || mode == this->mode)
+        return;
+
+    deleteStorage();
+    this->mode = mode;
+    createStorage();
+}
+
+void StreamingBuffer::release()
+{
+    deleteStorage();
+    frameSize = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// query the write paths (needs a current context with glad loaded)
+///////////////////////////////////////////////////////////////////////////////
+bool StreamingBuffer::isModeSupported(Mode mode)
+{
+    switch (mode)
+    {
+    case MODE_PERSISTENT:
+#ifdef GL_ARB_buffer_storage
+        return GLAD_GL_ARB_buffer_storage != 0;
+#else
+        return false;
+#endif
+    case MODE_AUTO:
+    case MODE_MAP_RANGE:
+    case MODE_SUBDATA:
+        return true;
+    }
+    return false;
+}
+
+const char* StreamingBuffer::getModeName(Mode mode)
+{
+    switch (mode)
+    {
+    case MODE_AUTO:       return "auto";
+    case MODE_PERSISTENT: return "persistent map";
+    case MODE_MAP_RANGE:  return "unsynchronized map range";
+    case MODE_SUBDATA:    return "glBufferSubData";
+    }
+    return "unknown";
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// wait for the region, then return a pointer to write this frame's data
+// For MODE_MAP_RANGE the range is mapped unsynchronized: the fence already
+// guarantees the GPU is done with it, so the driver must not wait again.
+///////////////////////////////////////////////////////////////////////////////
+void* StreamingBuffer::beginWrite(std::size_t size)
+{
+    if (size > frameSize || !id)
+        resize(size);
+
+    waitRegion(current);
+    writtenSize = size;
+    std::size_t offset = current * frameSize;
+
+    if (mode == MODE_PERSISTENT)
+        return mappedPtr + offset;
+
+    if (mode == MODE_MAP_RANGE)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+        return glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size,
+                                GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    }
+
+    staging.resize(size);
+    return staging.data();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// finish the write; returns the byte offset of the data in the buffer
+///////////////////////////////////////////////////////////////////////////////
+std::size_t StreamingBuffer::endWrite()
+{
+    std::size_t offset = current * frameSize;
+
+    if (mode == MODE_MAP_RANGE)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    else if (mode == MODE_SUBDATA)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, writtenSize, staging.data());
+    }
+    // MODE_PERSISTENT: coherent mapping, visible to the next draw as is
+
+    return offset;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// call after the draws that read this frame's region
+///////////////////////////////////////////////////////////////////////////////
+void StreamingBuffer::endFrame()
+{
+    if (fences[current])
+        glDeleteSync(fences[current]);
+    fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    current = (current + 1) % frameCount;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// allocate frameCount regions of frameSize bytes
+///////////////////////////////////////////////////////////////////////////////
+void StreamingBuffer::createStorage()
+{
+    std::size_t totalSize = frameSize * frameCount;
+    glGenBuffers(1, &id);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+
+#ifdef GL_ARB_buffer_storage
+    if (mode == MODE_PERSISTENT)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, 0, flags);
+        mappedPtr = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags);
+    }
+    else
+#endif
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, totalSize, 0, GL_STREAM_DRAW);
+    }
+
+    fences.assign(frameCount, (GLsync)0);
+    current = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// release the buffer; pending fences are dropped, GL defers the deletion
+// until the GPU is done with the buffer
+///////////////////////////////////////////////////////////////////////////////
+void StreamingBuffer::deleteStorage()
+{
+    for (std::size_t i = 0; i < fences.size(); ++i)
+    {
+        if (fences[i])
+            glDeleteSync(fences[i]);
+    }
+    fences.clear();
+
+    if (id)
+    {
+        if (mappedPtr)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            mappedPtr = 0;
+        }
+        glDeleteBuffers(1, &id);
+        id = 0;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// block until the GPU has finished reading the region
+///////////////////////////////////////////////////////////////////////////////
+void StreamingBuffer::waitRegion(int index)
+{
+    GLsync fence = fences[index];
+    if (!fence)
+        return;
+
+    const GLuint64 TIMEOUT_NS = 1000000;    // 1 ms per try
+    GLbitfield flags = 0;
+    while (true)
+    {
+        GLenum result = glClientWaitSync(fence, flags, TIMEOUT_NS);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+            break;
+        flags = GL_SYNC_FLUSH_COMMANDS_BIT;     // make sure the fence is submitted before waiting again
+    }
+
+    glDeleteSync(fence);
+    fences[index] = 0;
+}
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// StreamingBuffer.h
+// =================
+// Ring buffer for dynamic vertex data that is rewritten every frame.
+// The GPU buffer is split into N regions (3 by default). Each frame writes
+// into the next region while the GPU may still read the previous ones. A
+// fence sync is placed after the frame's draws, and a region is only reused
+// once its fence has signalled, so nothing stalls on orphaning or implicit
+// synchronization.
+//
+// Write paths (MODE_AUTO picks the first available):
+// - MODE_PERSISTENT: GL_ARB_buffer_storage, mapped once (persistent, coherent)
+// - MODE_MAP_RANGE:  glMapBufferRange(UNSYNCHRONIZED | INVALIDATE_RANGE) per frame (GL 3.3)
+// - MODE_SUBDATA:    CPU staging copy + glBufferSubData (fallback)
+//
+// usage:
+//     void* p = stream.beginWrite(bytes);     // fill p with this frame's data
+//     size_t offset = stream.endWrite();      // byte offset of the region in getId()
+//     ... point attributes at offset, draw ...
+//     stream.endFrame();                      // fence the region, advance
+//
+// The buffer is bound to GL_COPY_WRITE_BUFFER internally, so writing never
+// disturbs the GL_ARRAY_BUFFER binding or the element buffer of a bound VAO.
+// Regions are 256-byte aligned.
+// Like the other GL wrappers, the destructor does not touch GL: call release()
+// before the context is destroyed.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef STREAMING_BUFFER_H
+#define STREAMING_BUFFER_H
+
+#include <glad/glad.h>
+#include <vector>
+#include <cstddef>
+
+class StreamingBuffer
+{
+public:
+    enum Mode
+    {
+        MODE_AUTO,
+        MODE_PERSISTENT,
+        MODE_MAP_RANGE,
+        MODE_SUBDATA
+    };
+
+    // ctor/dtor
+    StreamingBuffer(std::size_t frameSize = 0, int frameCount = 3, Mode mode = MODE_AUTO);
+    ~StreamingBuffer();
+    StreamingBuffer(const StreamingBuffer&) = delete;
+    StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+    // getters/setters
+    void resize(std::size_t frameSize);             // re-create the storage (GL frees the old one once unused)
+    void setMode(Mode mode);                        // re-create the storage with another write path
+    void release();                                 // free the GL objects while the context is still current
+    Mode getMode() const { return mode; }
+    GLuint getId() const { return id; }
+    std::size_t getFrameSize() const { return frameSize; }
+    int getFrameCount() const { return frameCount; }
+    std::size_t getWrittenSize() const { return writtenSize; }   // bytes written this frame
+
+    static bool isModeSupported(Mode mode);
+    static const char* getModeName(Mode mode);
+
+    // per frame
+    void* beginWrite(std::size_t size);             // grows the storage if size > frameSize
+    std::size_t endWrite();                         // returns the byte offset of this frame's data
+    void endFrame();                                // fence the current region and move to the next
+
+private:
+    // member functions
+    void createStorage();
+    void deleteStorage();
+    void waitRegion(int index);
+
+    GLuint id;
+    Mode mode;                              // resolved write path, never MODE_AUTO
+    std::size_t frameSize;                  // bytes per region
+    int frameCount;                         // # of regions in the ring
+    int current;                            // region written this frame
+    std::size_t writtenSize;
+    unsigned char* mappedPtr;               // persistent mapping (MODE_PERSISTENT only)
+    std::vector<GLsync> fences;             // one per region, 0 if free
+    std::vector<unsigned char> staging;     // CPU copy (MODE_SUBDATA only)
+};
+
+#endif
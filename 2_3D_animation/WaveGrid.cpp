@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// WaveGrid.cpp
+// ============
+// Regular grid of wave sample points on the XZ plane.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include "WaveGrid.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+WaveGrid::WaveGrid(int width, int depth, float spacing, const glm::vec3& origin)
+    : width(std::max(width, 1)), depth(std::max(depth, 1)), spacing(spacing), origin(origin)
+{
+    buildBasePositions();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setters
+///////////////////////////////////////////////////////////////////////////////
+void WaveGrid::resize(int width, int depth, float spacing)
+{
+    this->width = std::max(width, 1);
+    this->depth = std::max(depth, 1);
+    this->spacing = spacing;
+    buildBasePositions();
+}
+
+void WaveGrid::setResolution(int width, int depth)
+{
+    width = std::max(width, 2);
+    depth = std::max(depth, 2);
+
+    // keep the longer side of the current extent
+    glm::vec2 extent = getExtent();
+    float length = std::max(extent.x, extent.y);
+    float spacing = length > 0 ? length / (std::max(width, depth) - 1) : this->spacing;
+    resize(width, depth, spacing);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// copy the base positions as packed vec3 (e.g. for a GPU upload)
+///////////////////////////////////////////////////////////////////////////////
+void WaveGrid::copyBasePositions(glm::vec3* out) const
+{
+    std::size_t count = getPointCount();
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = glm::vec3(baseX[i], baseY[i], baseZ[i]);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// build the index pairs connecting each point to its right (+z) and lower (+x)
+// neighbours. The connectivity depends only on the grid size, so this is done
+// once per resize and uploaded as a static element buffer.
+///////////////////////////////////////////////////////////////////////////////
+void WaveGrid::buildLineIndices(std::vector<unsigned int>& indices) const
+{
+    indices.clear();
+    indices.reserve(getLineCount() * 2);
+
+    for (int x = 0; x < width; ++x)
+    {
+        for (int z = 0; z < depth; ++z)
+        {
+            unsigned int index = (unsigned int)getIndex(x, z);
+            if (z < depth - 1)
+            {
+                indices.push_back(index);
+                indices.push_back(index + 1);
+            }
+            if (x < width - 1)
+            {
+                indices.push_back(index);
+                indices.push_back(index + depth);
+            }
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// generate the undisplaced positions, row (x) by row
+///////////////////////////////////////////////////////////////////////////////
+void WaveGrid::buildBasePositions()
+{
+    std::size_t count = getPointCount();
+    baseX.resize(count);
+    baseY.resize(count);
+    baseZ.resize(count);
+
+    for (int x = 0; x < width; ++x)
+    {
+        for (int z = 0; z < depth; ++z)
+        {
+            std::size_t i = getIndex(x, z);
+            baseX[i] = origin.x + x * spacing;
+            baseY[i] = origin.y;
+            baseZ[i] = origin.z + z * spacing;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// WaveGrid.h
+// ==========
+// Regular grid of wave sample points on the XZ plane.
+// Owns the undisplaced base positions in SoA form (x, y, z arrays) and is the
+// single source of the grid dimensions for both the wave simulation and the
+// line connectivity. The grid can be resized at runtime (re-gridding), either
+// with an explicit spacing or keeping the current extent.
+//
+// Point (x, z) is stored at index x * depth + z.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef WAVE_GRID_H
+#define WAVE_GRID_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+
+class WaveGrid
+{
+public:
+    // ctor/dtor
+    WaveGrid(int width = 20, int depth = 20, float spacing = 1.0f, const glm::vec3& origin = glm::vec3(-1.0f));
+    ~WaveGrid() {}
+
+    // getters/setters
+    void resize(int width, int depth, float spacing);
+    void setResolution(int width, int depth);               // keep the extent, adjust the spacing
+    int getWidth() const { return width; }                  // # of points along x (rows)
+    int getDepth() const { return depth; }                  // # of points along z (cols)
+    float getSpacing() const { return spacing; }
+    const glm::vec3& getOrigin() const { return origin; }
+    glm::vec2 getExtent() const { return glm::vec2((width - 1) * spacing, (depth - 1) * spacing); }
+
+    std::size_t getPointCount() const { return (std::size_t)width * depth; }
+    std::size_t getIndex(int x, int z) const { return (std::size_t)x * depth + z; }
+    std::size_t getLineCount() const { return (std::size_t)width * (depth - 1) + (std::size_t)(width - 1) * depth; }
+
+    const float* getBaseX() const { return baseX.data(); }
+    const float* getBaseY() const { return baseY.data(); }
+    const float* getBaseZ() const { return baseZ.data(); }
+    glm::vec3 getBasePosition(std::size_t index) const { return glm::vec3(baseX[index], baseY[index], baseZ[index]); }
+    void copyBasePositions(glm::vec3* out) const;           // packed vec3, getPointCount() entries
+
+    // line topology (GL_LINES index pairs into the point array), getLineCount() * 2 entries
+    // row x starts at x * (4 * depth - 2): right link then down link per point
+    void buildLineIndices(std::vector<unsigned int>& indices) const;
+
+private:
+    void buildBasePositions();
+
+    int width;
+    int depth;
+    float spacing;
+    glm::vec3 origin;                       // position of point (0, 0)
+    std::vector<float> baseX;
+    std::vector<float> baseY;
+    std::vector<float> baseZ;
+};
+
+#endif
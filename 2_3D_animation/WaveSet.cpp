@@ -0,0 +1,291 @@
+///////////////////////////////////////////////////////////////////////////////
+// WaveSet.cpp
+// ===========
+// Superposition of Gerstner waves with the per-wave constants baked once
+// into a structure-of-arrays table.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <algorithm>
+#include "WaveSet.h"
+#include "../common/simd_sincos.h"
+
+
+
+// constants //////////////////////////////////////////////////////////////////
+namespace
+{
+    const std::size_t MAX_STACK_WAVES = 64;
+    const double TWO_PI = 6.283185307179586;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctors
+///////////////////////////////////////////////////////////////////////////////
+WaveSet::WaveSet()
+{
+    setKernel(KERNEL_AUTO);
+}
+
+WaveSet::WaveSet(const std::vector<WaveParams>& waves)
+{
+    setKernel(KERNEL_AUTO);
+    setWaves(waves);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// replace the wave set and bake the per-wave constants
+// Gerstner wave: f = k * (dot(d, p) - c * t), a = steepness / k
+// offset = (d.x * a * cos(f), a * sin(f), d.y * a * cos(f))
+///////////////////////////////////////////////////////////////////////////////
+void WaveSet::setWaves(const std::vector<WaveParams>& waves)
+{
+    this->waves = waves;
+
+    std::size_t count = waves.size();
+    phaseX.resize(count);
+    phaseZ.resize(count);
+    omega.resize(count);
+    ampX.resize(count);
+    ampY.resize(count);
+    ampZ.resize(count);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const WaveParams& w = waves[i];
+        float k = 2.0f * 3.14159f / w.wavelength;
+        float c = sqrtf(9.8f / k) * w.speed;
+        glm::vec2 d = glm::normalize(w.direction);
+        float a = w.steepness / k;
+
+        phaseX[i] = k * d.x;
+        phaseZ[i] = k * d.y;
+        omega[i] = k * c;
+        ampX[i] = a * d.x;
+        ampY[i] = a;
+        ampZ[i] = a * d.y;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// The time term of each wave is wrapped to [0, 2pi) in double precision so the
+// phase stays small (and accurate for the polynomial sincos) as time grows.
+// Every CPU path goes through here, so they agree at any time.
+///////////////////////////////////////////////////////////////////////////////
+const float* WaveSet::computeOmegaT(float time, float* stackOmegaT, std::vector<float>& heapOmegaT) const
+{
+    std::size_t waveCount = omega.size();
+    float* omegaT = stackOmegaT;
+    if (waveCount > MAX_STACK_WAVES)
+    {
+        heapOmegaT.resize(waveCount);
+        omegaT = heapOmegaT.data();
+    }
+    for (std::size_t i = 0; i < waveCount; ++i)
+        omegaT[i] = (float)fmod((double)omega[i] * time, TWO_PI);
+    return omegaT;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// return the displaced position of a grid point
+///////////////////////////////////////////////////////////////////////////////
+glm::vec3 WaveSet::displace(const glm::vec3& basePos, float time) const
+{
+    float stackOmegaT[MAX_STACK_WAVES];
+    std::vector<float> heapOmegaT;
+    return displacePoint(basePos, computeOmegaT(time, stackOmegaT, heapOmegaT));
+}
+
+glm::vec3 WaveSet::displacePoint(const glm::vec3& basePos, const float* omegaT) const
+{
+    glm::vec3 pos = basePos;
+    std::size_t count = phaseX.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        float f = phaseX[i] * basePos.x + phaseZ[i] * basePos.z - omegaT[i];
+        float cosF = cosf(f);
+        pos.x += ampX[i] * cosF;
+        pos.y += ampY[i] * sinf(f);
+        pos.z += ampZ[i] * cosF;
+    }
+    return pos;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// displace a batch of grid points
+///////////////////////////////////////////////////////////////////////////////
+void WaveSet::displace(const glm::vec3* basePos, glm::vec3* outPos, std::size_t count, float time) const
+{
+    float stackOmegaT[MAX_STACK_WAVES];
+    std::vector<float> heapOmegaT;
+    const float* omegaT = computeOmegaT(time, stackOmegaT, heapOmegaT);
+    for (std::size_t i = 0; i < count; ++i)
+        outPos[i] = displacePoint(basePos[i], omegaT);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// displace a batch of grid points given as SoA base arrays
+///////////////////////////////////////////////////////////////////////////////
+void WaveSet::displace(const float* baseX, const float* baseY, const float* baseZ, glm::vec3* outPos, std::size_t count, float time) const
+{
+    float stackOmegaT[MAX_STACK_WAVES];
+    std::vector<float> heapOmegaT;
+    const float* omegaT = computeOmegaT(time, stackOmegaT, heapOmegaT);
+
+    switch (kernel)
+    {
+    case KERNEL_AVX2:
+        displaceAVX2(baseX, baseY, baseZ, outPos, count, omegaT);
+        break;
+    case KERNEL_SSE2:
+        displaceSSE2(baseX, baseY, baseZ, outPos, count, omegaT);
+        break;
+    default:
+        displaceScalar(baseX, baseY, baseZ, outPos, count, omegaT);
+        break;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// scalar batch kernel (libm cos/sin), also used for the SIMD remainders
+///////////////////////////////////////////////////////////////////////////////
+void WaveSet::displaceScalar(const float* baseX, const float* baseY, const float* baseZ, glm::vec3* outPos, std::size_t count, const float* omegaT) const
+{
+    std::size_t waveCount = omega.size();
+    for (std::size_t p = 0; p < count; ++p)
+    {
+        float x = baseX[p];
+        float z = baseZ[p];
+        glm::vec3 pos(x, baseY[p], z);
+        for (std::size_t i = 0; i < waveCount; ++i)
+        {
+            float f = phaseX[i] * x + phaseZ[i] * z - omegaT[i];
+            float cosF = cosf(f);
+            pos.x += ampX[i] * cosF;
+            pos.y += ampY[i] * sinf(f);
+            pos.z += ampZ[i] * cosF;
+        }
+        outPos[p] = pos;
+    }
+}
+
+
+
+#ifdef SIMD_X86
+///////////////////////////////////////////////////////////////////////////////
+// SSE2 batch kernel: 4 points per iteration
+///////////////////////////////////////////////////////////////////////////////
+void WaveSet::displaceSSE2(const float* baseX, const float* baseY, const float* baseZ, glm::vec3* outPos, std::size_t count, const float* omegaT) const
+{
+    std::size_t waveCount = omega.size();
+    std::size_t p = 0;
+    for (; p + 4 <= count; p += 4)
+    {
+        __m128 x = _mm_loadu_ps(baseX + p);
+        __m128 z = _mm_loadu_ps(baseZ + p);
+        __m128 px = x;
+        __m128 py = _mm_loadu_ps(baseY + p);
+        __m128 pz = z;
+        for (std::size_t i = 0; i < waveCount; ++i)
+        {
+            __m128 f = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(phaseX[i]), x), _mm_mul_ps(_mm_set1_ps(phaseZ[i]), z));
+            f = _mm_sub_ps(f, _mm_set1_ps(omegaT[i]));
+            __m128 sinF, cosF;
+            sincos4(f, &sinF, &cosF);
+            px = _mm_add_ps(px, _mm_mul_ps(_mm_set1_ps(ampX[i]), cosF));
+            py = _mm_add_ps(py, _mm_mul_ps(_mm_set1_ps(ampY[i]), sinF));
+            pz = _mm_add_ps(pz, _mm_mul_ps(_mm_set1_ps(ampZ[i]), cosF));
+        }
+
+        // SoA -> packed vec3
+        float tx[4], ty[4], tz[4];
+        _mm_storeu_ps(tx, px);
+        _mm_storeu_ps(ty, py);
+        _mm_storeu_ps(tz, pz);
+        for (int k = 0; k < 4; ++k)
+            outPos[p + k] = glm::vec3(tx[k], ty[k], tz[k]);
+    }
+    displaceScalar(baseX + p, baseY + p, baseZ + p, outPos + p, count - p, omegaT);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AVX2 batch kernel: 8 points per iteration
+///////////////////////////////////////////////////////////////////////////////
+SIMD_TARGET_AVX2
+void WaveSet::displaceAVX2(const float* baseX, const float* baseY, const float* baseZ, glm::vec3* outPos, std::size_t count, const float* omegaT) const
+{
+    std::size_t waveCount = omega.size();
+    std::size_t p = 0;
+    for (; p + 8 <= count; p += 8)
+    {
+        __m256 x = _mm256_loadu_ps(baseX + p);
+        __m256 z = _mm256_loadu_ps(baseZ + p);
+        __m256 px = x;
+        __m256 py = _mm256_loadu_ps(baseY + p);
+        __m256 pz = z;
+        for (std::size_t i = 0; i < waveCount; ++i)
+        {
+            __m256 f = _mm256_fmsub_ps(_mm256_set1_ps(phaseZ[i]), z, _mm256_set1_ps(omegaT[i]));
+            f = _mm256_fmadd_ps(_mm256_set1_ps(phaseX[i]), x, f);
+            __m256 sinF, cosF;
+            sincos8(f, &sinF, &cosF);
+            px = _mm256_fmadd_ps(_mm256_set1_ps(ampX[i]), cosF, px);
+            py = _mm256_fmadd_ps(_mm256_set1_ps(ampY[i]), sinF, py);
+            pz = _mm256_fmadd_ps(_mm256_set1_ps(ampZ[i]), cosF, pz);
+        }
+
+        float tx[8], ty[8], tz[8];
+        _mm256_storeu_ps(tx, px);
+        _mm256_storeu_ps(ty, py);
+        _mm256_storeu_ps(tz, pz);
+        for (int k = 0; k < 8; ++k)
+            outPos[p + k] = glm::vec3(tx[k], ty[k], tz[k]);
+    }
+    displaceScalar(baseX + p, baseY + p, baseZ + p, outPos + p, count - p, omegaT);
+}
+
+#else
+// no SIMD paths on this architecture; isKernelSupported() never selects them
+void WaveSet::displaceSSE2(const float* baseX, const float* baseY, const float* baseZ, glm::vec3* outPos, std::size_t count, const float* omegaT) const
+{
+    displaceScalar(baseX, baseY, baseZ, outPos, count, omegaT);
+}
+
+void WaveSet::displaceAVX2(const float* baseX, const float* baseY, const float* baseZ, glm::vec3* outPos, std::size_t count, const float* omegaT) const
+{
+    displaceScalar(baseX, baseY, baseZ, outPos, count, omegaT);
+}
+#endif
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// pack the baked constants for the "Waves" uniform block
+///////////////////////////////////////////////////////////////////////////////
+WaveBlock WaveSet::getUniformBlock() const
+{
+    WaveBlock block = {};
+    block.waveCount = (int)std::min(phaseX.size(), (std::size_t)MAX_WAVES);
+    for (int i = 0; i < block.waveCount; ++i)
+    {
+        block.waves[i].phase = glm::vec4(phaseX[i], phaseZ[i], omega[i], 0.0f);
+        block.waves[i].amplitude = glm::vec4(ampX[i], ampZ[i], ampY[i], 0.0f);
+    }
+    return block;
+}
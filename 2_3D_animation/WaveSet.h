@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////
+// WaveSet.h
+// =========
+// Superposition of Gerstner waves with the per-wave constants baked once
+// (k, c, normalized direction, amplitude) into a structure-of-arrays table.
+// The per-point kernel only reads the baked table, so nothing is recomputed
+// per grid point. The same table feeds the "Waves" uniform block used by
+// 7.4.camera.vs in GPU mode.
+//
+// The batched SoA kernel has SSE2 (4 points) and AVX2+FMA (8 points) paths
+// using a polynomial sincos, selected at runtime by CPU feature detection,
+// and a scalar libm fallback. Max abs position error of the SIMD paths
+// against the scalar path is WAVE_SIMD_MAX_ERROR (5e-6) on a +-10 grid (a
+// few ulp of the coordinates); the wave phase is wrapped per frame so it does
+// not grow with time. wave_benchmark.cpp checks the bound and measures the
+// throughput of each kernel.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef WAVE_SET_H
+#define WAVE_SET_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+#include "../common/simd_sincos.h"
+
+// 1. นิยามโครงสร้างคลื่น
+struct WaveParams {
+    glm::vec2 direction; // ทิศทางที่คลื่นวิ่งไป
+    float steepness;     // ความแหลมของยอดคลื่น (0.0 - 1.0)
+    float wavelength;    // ความยาวคลื่น
+    float speed;         // ความเร็ว
+};
+
+// max abs position error of the SIMD kernels against KERNEL_SCALAR, |x|, |z| <= 10, any time
+const float WAVE_SIMD_MAX_ERROR = 5e-6f;     // ~5 ulp of coordinates up to 16
+
+// std140 mirror of the "Waves" uniform block in 7.4.camera_common.glsl
+const int MAX_WAVES = 8;
+struct WaveBlock {
+    struct {
+        glm::vec4 phase;        // xy: k * direction, z: k * c (angular frequency)
+        glm::vec4 amplitude;    // xy: a * direction, z: a
+    } waves[MAX_WAVES];
+    int waveCount;
+    int pad[3];
+};
+
+class WaveSet
+{
+public:
+    // batched kernel implementations
+    enum Kernel
+    {
+        KERNEL_AUTO = SIMD_KERNEL_AUTO,
+        KERNEL_SCALAR = SIMD_KERNEL_SCALAR,
+        KERNEL_SSE2 = SIMD_KERNEL_SSE2,
+        KERNEL_AVX2 = SIMD_KERNEL_AVX2
+    };
+
+    // ctor/dtor
+    WaveSet();
+    explicit WaveSet(const std::vector<WaveParams>& waves);
+    ~WaveSet() {}
+
+    // getters/setters
+    void setWaves(const std::vector<WaveParams>& waves);   // re-bakes the constants table
+    const std::vector<WaveParams>& getWaves() const { return waves; }
+    int getWaveCount() const { return (int)waves.size(); }
+
+    // displaced position of one grid point at the given time
+    glm::vec3 displace(const glm::vec3& basePos, float time) const;
+    // displace count points at once
+    void displace(const glm::vec3* basePos, glm::vec3* outPos, std::size_t count, float time) const;
+    // displace count points given as SoA base arrays, written as packed vec3 ready for upload
+    void displace(const float* baseX, const float* baseY, const float* baseZ, glm::vec3* outPos, std::size_t count, float time) const;
+
+    // kernel used by the SoA batch (KERNEL_AUTO picks the best one this CPU supports)
+    void setKernel(Kernel kernel) { this->kernel = (Kernel)simdSelectKernel((SimdKernel)kernel); }
+    Kernel getKernel() const { return kernel; }
+    static const char* getKernelName(Kernel kernel) { return simdKernelName((SimdKernel)kernel); }
+    static bool isKernelSupported(Kernel kernel) { return simdIsKernelSupported((SimdKernel)kernel); }
+
+    // uniform block for the GPU path (first MAX_WAVES waves)
+    WaveBlock getUniformBlock() const;
+
+private:
+    // time term of every wave, wrapped to [0, 2pi) in double precision; written to
+    // stackOmegaT (MAX_STACK_WAVES entries) or, for more waves, to heapOmegaT
+    const float* computeOmegaT(float time, float* stackOmegaT, std::vector<float>& heapOmegaT) const;
+    glm::vec3 displacePoint(const glm::vec3& basePos, const float* omegaT) const;
+
+    // batch kernels
+    void displaceScalar(const float* baseX, const float* baseY, const float* baseZ, glm::vec3* outPos, std::size_t count, const float* omegaT) const;
+    void displaceSSE2(const float* baseX, const float* baseY, const float* baseZ, glm::vec3* outPos, std::size_t count, const float* omegaT) const;
+    void displaceAVX2(const float* baseX, const float* baseY, const float* baseZ, glm::vec3* outPos, std::size_t count, const float* omegaT) const;
+
+    std::vector<WaveParams> waves;
+    Kernel kernel = KERNEL_AUTO;
+
+    // baked constants (SoA), one entry per wave
+    std::vector<float> phaseX;      // k * d.x
+    std::vector<float> phaseZ;      // k * d.y
+    std::vector<float> omega;       // k * c
+    std::vector<float> ampX;        // a * d.x
+    std::vector<float> ampY;        // a
+    std::vector<float> ampZ;        // a * d.y
+};
+
+#endif
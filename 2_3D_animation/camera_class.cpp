@@ -6,15 +6,33 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <learnopengl/filesystem.h>
-#include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
+#include "../common/shader_cached.h"
 #include "Icosphere.h"
+#include "IcosphereLodChain.h"
+#include "IcosphereTessellator.h"
+#include "MeshCache.h"
+#include "WaveSet.h"
+#include "JobSystem.h"
+#include "WaveGrid.h"
+#include "StreamingBuffer.h"
+#include "Profiler.h"
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow *window);
+void benchmarkStreamingUploads();
 
 // settings
 const unsigned int SCR_WIDTH = 1080;
@@ -26,26 +44,84 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
+// rendering
+const bool instancedMode = true;   // draw the whole sphere grid with a single glDrawElementsInstanced call
+const bool gpuWaves = false;       // evaluate the Gerstner waves in the vertex shader instead of on the CPU
+const bool benchmarkStreaming = false;  // print the per-frame upload cost of each StreamingBuffer path at startup
+const bool profiling = true;       // per-pass CPU/GPU timings in the window title (--profile also dumps CSV + Chrome trace at exit)
+const bool lodMode = true;         // pick the sphere subdivision per instance from its projected size
+const bool tessellatedSpheres = false; // GL 4.0: subdivide the icosahedron per instance in tessellation shaders (CPU LOD chain on 3.3)
+const Icosphere::VertexFormat sphereVertexFormat = Icosphere::VERTEX_FORMAT_PACKED;  // 16-byte sphere vertices (32 with VERTEX_FORMAT_FLOAT)
+
+// wave grid
+int gridWidth = 20;                 // points along x, halved/doubled at runtime with [ and ]
+int gridDepth = 20;                 // points along z
+bool gridChanged = false;
+const float frameBudgetMs = 0.0f;   // > 0: rescale the grid resolution to hold this frame time
+
+// per-frame uniform block of the scene shaders ("Frame" in 7.4.camera_common.glsl, std140)
+struct FrameUniforms
+{
+    glm::mat4 projection;
+    glm::mat4 view;
+    float time;
+    float padding[3];
+};
+const unsigned int WAVES_BINDING = 0;
+const unsigned int FRAME_BINDING = 1;
+
+// headless benchmark (--headless --frames N --grid WxH)
+const float FIXED_TIMESTEP = 1.0f / 60.0f;  // simulated time per frame, so runs are reproducible
+const int WARMUP_FRAMES = 10;               // not included in the frame time statistics
+
+// CPU/GPU wave parity check (--parity): max abs difference of the displaced grid points
+const float PARITY_TOLERANCE = 1e-3f;       // world units, the spheres are 0.25 across
+const float PARITY_TIMES[] = { 0.0f, 1.7f, 10.0f, 60.0f };
+float checkWaveParity(const WaveSet& waveSet, const WaveGrid& grid, UniformBuffer<FrameUniforms>& frameUBO, float time);
+
 // timing
 float deltaTime = 0.0f;	// time between current frame and last frame
 float lastFrame = 0.0f;
 
-// 1. นิยามโครงสร้างคลื่น (วางไว้นอก loop หรือบนสุดของ main ก็ได้)
-struct WaveParams {
-    glm::vec2 direction; // ทิศทางที่คลื่นวิ่งไป
-    float steepness;     // ความแหลมของยอดคลื่น (0.0 - 1.0)
-    float wavelength;    // ความยาวคลื่น
-    float speed;         // ความเร็ว
-};
-
-int main()
+int main(int argc, char* argv[])
 {
+    // command line
+    // ------------
+    bool headless = false;                  // invisible window, render into an FBO, fixed timestep
+    bool parityCheck = false;               // compare the GPU waves against the CPU solve, then exit
+    bool profileDump = false;               // write profile.csv and profile.json at exit
+    int benchmarkFrames = 600;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        else if (std::strcmp(argv[i], "--parity") == 0)
+            parityCheck = true;
+        else if (std::strcmp(argv[i], "--profile") == 0)
+            profileDump = true;
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            benchmarkFrames = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--grid") == 0 && i + 1 < argc &&
+                 std::sscanf(argv[++i], "%dx%d", &gridWidth, &gridDepth) == 2)
+        {
+            gridWidth = std::min(4096, std::max(2, gridWidth));
+            gridDepth = std::min(4096, std::max(2, gridDepth));
+        }
+        else
+        {
+            std::cout << "usage: " << argv[0] << " [--headless] [--parity] [--profile] [--frames N] [--grid WxH]" << std::endl;
+            return -1;
+        }
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, tessellatedSpheres ? 4 : 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, tessellatedSpheres ? 0 : 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (headless)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -54,6 +130,13 @@ int main()
     // glfw window creation
     // --------------------
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    if (window == NULL && tessellatedSpheres)
+    {
+        // no GL 4.0: a 3.3 context, the spheres use the CPU mesh
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    }
     if (window == NULL)
     {
         std::cout << "Failed to create GLFW window" << std::endl;
@@ -64,9 +147,11 @@ int main()
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     // tell GLFW to capture our mouse
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (!headless)
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
@@ -80,92 +165,349 @@ int main()
     // -----------------------------
     glEnable(GL_DEPTH_TEST);
 
+    // headless: render into an offscreen framebuffer of the window size, nothing is presented
+    unsigned int offscreenFBO = 0, offscreenColor = 0, offscreenDepth = 0;
+    if (headless)
+    {
+        glGenFramebuffers(1, &offscreenFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, offscreenFBO);
+        glGenRenderbuffers(1, &offscreenColor);
+        glBindRenderbuffer(GL_RENDERBUFFER, offscreenColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColor);
+        glGenRenderbuffers(1, &offscreenDepth);
+        glBindRenderbuffer(GL_RENDERBUFFER, offscreenDepth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreenDepth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "Failed to create the offscreen framebuffer" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+        std::cout << "Headless: " << benchmarkFrames << " frames, grid " << gridWidth << " x " << gridDepth
+                  << ", fixed timestep " << FIXED_TIMESTEP << " s, " << SCR_WIDTH << " x " << SCR_HEIGHT << " offscreen" << std::endl;
+    }
+
     // build and compile our shader zprogram
     // ------------------------------------
-    Shader ourShader("7.4.camera.vs", "7.4.camera.fs");
+    CachedShader ourShader("7.4.camera.vs", "7.4.camera.fs");
+
+    // spheres from tessellated icosahedron patches when the context has GL 4.0, the CPU LOD chain otherwise
+    IcosphereTessellator sphereTess;
+    const bool tessMode = tessellatedSpheres && IcosphereTessellator::isSupported() &&
+                          sphereTess.create("7.4.camera_tess.vs", "7.4.camera_tess.tcs", "7.4.camera_tess.tes", "7.4.camera.fs");
+    const bool cpuLods = lodMode && !tessMode;  // per-instance levels picked on the CPU
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
-    // Create Icosphere:
-    Icosphere sphere(0.25f, 8, true);
-
-    unsigned int VBO, VAO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    // Upload Interleaved Data (Pos, Normal, TexCoord)
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sphere.getInterleavedVertexSize(), sphere.getInterleavedVertices(), GL_STATIC_DRAW);
-
-    // Upload Indices
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphere.getIndexSize(), sphere.getIndices(), GL_STATIC_DRAW);
+    if (benchmarkStreaming)
+        benchmarkStreamingUploads();
+
+    // worker threads for the per-frame simulation (and the sphere generation); the render thread helps while it waits
+    JobSystem jobs;
+    std::cout << "Job system: " << jobs.getWorkerCount() << " worker thread(s)" << std::endl;
+
+    // Create Icosphere: subdivision 1, 2, 4 and 8 in one vertex/index buffer, the finest one when lodMode is off
+    const float SPHERE_RADIUS = 0.25f;
+    // the levels come from the on-disk mesh cache after the first run (cold: generate + save, warm: map + copy)
+    MeshCache meshCache("mesh_cache");
+    auto lodStart = std::chrono::steady_clock::now();
+    // unit sphere, SPHERE_RADIUS is part of the model scale, so a size change never touches the vertex data
+    IcosphereLodChain sphereLods(1.0f, { 1, 2, 4, 8 }, true, sphereVertexFormat, &meshCache, &jobs);
+    std::cout << "Sphere LODs: " << sphereLods.getLevelCount() << " levels in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lodStart).count() << " ms ("
+              << (sphereLods.getCacheHits() == sphereLods.getLevelCount() ? "warm" : "cold") << " start, "
+              << sphereLods.getCacheHits() << " cached)" << std::endl;
+    std::cout << "Sphere backend: " << (tessMode ? "GPU tessellation" : "CPU LOD chain") << ", "
+              << (tessMode ? IcosphereTessellator::getMemorySize() : sphereLods.getInterleavedVertexSize() + sphereLods.getIndexSize())
+              << " bytes of sphere geometry" << std::endl;
+    const int finestLod = sphereLods.getLevelCount() - 1;
+
+    // one VAO/VBO/EBO for all levels, attributes as described by the vertex format:
+    // location 0 position, 1 normal, 2 texcoord
+    sphereLods.createBuffers();
+    const unsigned int sphereVAO = sphereLods.getBuffers().getVao();
+    glBindVertexArray(sphereVAO);
+
+    // Displaced grid positions, one vec3 per point, streamed once per frame and shared by
+    // the spheres (per-instance offsets, location 3) and the lines (vertex positions, location 0)
+    // the ring moves every frame, so both attribute pointers are re-pointed at the new offset after each write
+    // when the instance attribute is disabled the shader reads (0,0,0) and the model matrix places the sphere instead
+    StreamingBuffer positionStream((std::size_t)gridWidth * gridDepth * sizeof(glm::vec3));
+    std::size_t positionOffset = 0;
+    std::cout << "Position stream: " << StreamingBuffer::getModeName(positionStream.getMode()) << std::endl;
+    glBindBuffer(GL_ARRAY_BUFFER, positionStream.getId());
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glVertexAttribDivisor(3, 1);
+    if (instancedMode)
+        glEnableVertexAttribArray(3);
+    if (tessMode)
+    {
+        glBindVertexArray(sphereTess.getVao());
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glVertexAttribDivisor(3, 1);
+        if (instancedMode)
+            glEnableVertexAttribArray(3);
+    }
 
-    // Attributes (Stride is usually 32 bytes: 3+3+2 floats)
-    int stride = 8 * sizeof(float);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // tessMode: triangles generated by the tessellator, from a ring of queries read a few frames late
+    // a result is read only once GL_QUERY_RESULT_AVAILABLE is set, so the count never stalls the frame
+    const int TESS_QUERY_COUNT = 4;
+    unsigned int tessQueries[TESS_QUERY_COUNT] = {};
+    int tessQueryNext = 0;                  // query of the next frame
+    int tessQueriesPending = 0;             // issued and not read yet, the ones right before tessQueryNext
+    std::size_t tessTriangles = 0;          // latest result
+    if (tessMode)
+        glGenQueries(TESS_QUERY_COUNT, tessQueries);
+
+    // lodMode: the instance offsets regrouped by LOD level, one contiguous range per level
+    // each level is one instanced draw with location 3 pointed at the start of its range
+    StreamingBuffer lodStream(instancedMode && cpuLods ? (std::size_t)gridWidth * gridDepth * sizeof(glm::vec3) : 0);
+    std::vector<float> lodDistances;                        // per level, squared switch distance
+    std::vector<unsigned char> pointLods;                   // level of each grid point
+    std::vector<std::size_t> lodCounts(sphereLods.getLevelCount());
+    std::vector<std::size_t> lodStarts(sphereLods.getLevelCount());
+    std::vector<std::size_t> lodNext(sphereLods.getLevelCount());      // scatter cursor per level
+    std::size_t lodOffset = 0;
 
     // --- SETUP LINE RENDERING ---
-    unsigned int lineVAO, lineVBO;
+    // the line topology never changes for a given grid size: static index pairs into the position stream
+    unsigned int lineVAO, lineEBO;
     glGenVertexArrays(1, &lineVAO);
-    glGenBuffers(1, &lineVBO);
+    glGenBuffers(1, &lineEBO);
 
     glBindVertexArray(lineVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, positionStream.getId());
     // เราจะส่งข้อมูลแค่ Position (vec3) เข้าไป
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lineEBO);
+
+    // world space positions of our cubes (base positions of the wave grid, spacing 1 from (-1, -1, -1))
+    WaveGrid grid(gridWidth, gridDepth, 1.0f, glm::vec3(-1.0f, -1.0f, -1.0f));
+
+    // สร้างชุดคลื่นสัก 3-4 ลูก เพื่อทำ Superposition (การซ้อนทับ)
+    std::vector<WaveParams> waves = {
+        { { 1.0f,  0.1f },   0.35f,       20.0f,       0.80f },
+        { { 0.5f,  1.0f },   0.30f,       15.0f,       1.0f },
+        { {-0.3f,  0.8f },   0.25f,        8.0f,       1.20f }, 
+        { { 0.8f, -0.4f },   0.20f,        4.0f,       1.50f }
+    };
 
-    // world space positions of our cubes
-    std::vector<glm::vec3> cubePositions;
-    float startX = -1.0f;
-    float startY = -1.0f;
-    float startZ = -1.0f;
-    float offset = 1.0f;
+    // bake k, c, direction and amplitude once per wave (redo setWaves() whenever waves change)
+    WaveSet waveSet(waves);
+    std::cout << "Gerstner kernel: " << WaveSet::getKernelName(waveSet.getKernel()) << std::endl;
+
+    // upload the wave set once; in gpuWaves mode only "time" changes per frame
+    WaveBlock waveBlock = waveSet.getUniformBlock();
+    unsigned int waveUBO;
+    glGenBuffers(1, &waveUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, waveUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(WaveBlock), &waveBlock, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, WAVES_BINDING, waveUBO);
+
+    // projection, view and time: one block shared by both sphere programs and the lines
+    UniformBuffer<FrameUniforms> frameUBO(FRAME_BINDING);
+    ourShader.bindBlock("Waves", WAVES_BINDING);
+    ourShader.bindBlock("Frame", FRAME_BINDING);
+    if (tessMode)
+    {
+        sphereTess.getShader().bindBlock("Waves", WAVES_BINDING);
+        sphereTess.getShader().bindBlock("Frame", FRAME_BINDING);
+    }
 
-    for (int x = 0; x < 20; ++x)
+    // de-allocate the GL resources while the context is still current, on every exit path from here
+    // (none of the classes delete GL objects in their destructors)
+    auto releaseGlResources = [&]()
     {
-        for (int y = 0; y < 1; ++y)
+        sphereLods.releaseBuffers();
+        sphereTess.release();
+        ourShader.release();
+        frameUBO.release();
+        if (tessMode)
+            glDeleteQueries(TESS_QUERY_COUNT, tessQueries);
+        glDeleteVertexArrays(1, &lineVAO);
+        glDeleteBuffers(1, &lineEBO);
+        positionStream.release();
+        lodStream.release();
+        if (headless)
         {
-            for (int z = 0; z < 20; ++z)
+            glDeleteFramebuffers(1, &offscreenFBO);
+            glDeleteRenderbuffers(1, &offscreenColor);
+            glDeleteRenderbuffers(1, &offscreenDepth);
+        }
+        glDeleteBuffers(1, &waveUBO);
+    };
+
+    // --parity: the vertex shader's Gerstner waves against WaveSet on the CPU, for every grid point
+    if (parityCheck)
+    {
+        float maxError = 0.0f;
+        for (float time : PARITY_TIMES)
+        {
+            float error = checkWaveParity(waveSet, grid, frameUBO, time);
+            if (error < 0.0f)
             {
-                cubePositions.push_back(glm::vec3(startX + x * offset, startY + y * offset, startZ + z * offset));
+                maxError = error;
+                break;
             }
+            maxError = std::max(maxError, error);
         }
+        bool passed = maxError >= 0.0f && maxError <= PARITY_TOLERANCE;
+        std::printf("wave parity, grid %d x %d, %s kernel: max |GPU - CPU| %g (tolerance %g) %s\n",
+                    grid.getWidth(), grid.getDepth(), WaveSet::getKernelName(waveSet.getKernel()),
+                    maxError, PARITY_TOLERANCE, passed ? "PASS" : "FAIL");
+        releaseGlResources();
+        glfwTerminate();
+        return passed ? 0 : 1;
     }
 
+    // per-draw uniforms, resolved once
+    const int modelLoc = ourShader.location("model");
+    const int gpuWavesLoc = ourShader.location("gpuWaves");
+    const int perVertexWavesLoc = ourShader.location("perVertexWaves");
+    const int tessModelLoc = tessMode ? sphereTess.getShader().location("model") : -1;
+    const int tessGpuWavesLoc = tessMode ? sphereTess.getShader().location("gpuWaves") : -1;
 
+    // in gpuWaves mode the base positions never change, so they are uploaded only once
+    bool staticPositionsUploaded = false;
 
-    // สร้างชุดคลื่นสัก 3-4 ลูก เพื่อทำ Superposition (การซ้อนทับ)
-    std::vector<WaveParams> waves = {
-        { { 1.0f,  0.1f },   0.35f,       20.0f,       0.80f },
-        { { 0.5f,  1.0f },   0.30f,       15.0f,       1.0f },
-        { {-0.3f,  0.8f },   0.25f,        8.0f,       1.20f }, 
-        { { 0.8f, -0.4f },   0.20f,        4.0f,       1.50f }
-    };
+    const std::size_t TILE_POINTS = 4096;   // approximate # of grid points per tile
+
+    // per-frame buffers, sized once per grid resolution
+    // (the CPU copy is read by the per-sphere path and the LOD selection, otherwise the instanced path solves into the stream)
+    std::vector<glm::vec3> currentFramePos(grid.getPointCount());  // เก็บตำแหน่งของเฟรมนี้
+    std::vector<unsigned int> lineIndices;
+    gridChanged = true;                 // build the line topology on the first frame
+
+    // frame time average for the resolution budget
+    float budgetTime = 0.0f;
+    int budgetFrames = 0;
+
+    // per-pass timings: CPU scopes (also on the workers) and GPU timer queries
+    Profiler profiler(1 << 16, profiling || profileDump);
+    float overlayTime = 0.0f;
+    int overlayFrames = 0;
+    std::size_t sphereTriangles = 0;        // drawn in the last frame
+
+    // headless frame times (ms), wall clock including glFinish
+    std::vector<double> frameTimes;
+    frameTimes.reserve(benchmarkFrames);
+    int frameIndex = 0;
 
     // render loop
     // -----------
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && (!headless || frameIndex < benchmarkFrames))
     {
-        float time = static_cast<float>(glfwGetTime());
-        // per-frame time logic
+        auto frameStart = std::chrono::steady_clock::now();
+
+        // per-frame time logic (simulated time when headless)
         // --------------------
-        float currentFrame = static_cast<float>(glfwGetTime());
+        float currentFrame = headless ? frameIndex * FIXED_TIMESTEP : static_cast<float>(glfwGetTime());
+        float time = currentFrame;
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        profiler.beginFrame();
+
+        // overlay: refresh the window title twice a second
+        overlayTime += deltaTime;
+        ++overlayFrames;
+        if (profiling && !headless && overlayTime >= 0.5f)
+        {
+            std::string title = "LearnOpenGL | " + std::to_string((int)(overlayFrames / overlayTime + 0.5f)) + " fps | " +
+                                profiler.getSummary(overlayFrames) + " (ms) | " + std::to_string(sphereTriangles / 1000) + "k sphere tris";
+            glfwSetWindowTitle(window, title.c_str());
+            overlayTime = 0.0f;
+            overlayFrames = 0;
+        }
+
+        // scale the grid resolution to the frame-time budget (averaged over 30 frames)
+        if (frameBudgetMs > 0.0f)
+        {
+            budgetTime += deltaTime;
+            if (++budgetFrames == 30)
+            {
+                float averageMs = budgetTime / budgetFrames * 1000.0f;
+                float scale = 1.0f;
+                if (averageMs > frameBudgetMs * 1.15f)
+                    scale = 0.8f;
+                else if (averageMs < frameBudgetMs * 0.7f)
+                    scale = 1.25f;
+                gridWidth = std::min(4096, std::max(2, (int)(gridWidth * scale + 0.5f)));
+                gridDepth = std::min(4096, std::max(2, (int)(gridDepth * scale + 0.5f)));
+                gridChanged = gridChanged || gridWidth != grid.getWidth() || gridDepth != grid.getDepth();
+                budgetTime = 0.0f;
+                budgetFrames = 0;
+            }
+        }
+
+        // re-grid without restarting: new base positions, per-frame buffers and static uploads
+        if (gridChanged)
+        {
+            gridChanged = false;
+            if (gridWidth != grid.getWidth() || gridDepth != grid.getDepth())
+                grid.setResolution(gridWidth, gridDepth);
+            currentFramePos.resize(grid.getPointCount());
+            pointLods.resize(grid.getPointCount());
+            staticPositionsUploaded = false;
+
+            {
+                Profiler::CpuScope scope(profiler, "line build");
+                grid.buildLineIndices(lineIndices);
+                glBindVertexArray(lineVAO);             // lineEBO is part of the line VAO state
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, lineEBO);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, lineIndices.size() * sizeof(unsigned int), lineIndices.data(), GL_STATIC_DRAW);
+            }
+
+            // per-frame upload: unique positions only vs. sphere offsets + 2 duplicated vertices per line
+            std::size_t uploadBytes = grid.getPointCount() * sizeof(glm::vec3);
+            std::size_t duplicatedBytes = (instancedMode ? uploadBytes : 0) + grid.getLineCount() * 2 * sizeof(glm::vec3);
+            std::cout << "Wave grid: " << grid.getWidth() << " x " << grid.getDepth()
+                      << ", spacing " << grid.getSpacing()
+                      << ", upload " << uploadBytes << " bytes/frame (was " << duplicatedBytes << ")" << std::endl;
+        }
+        const int cols = grid.getDepth();
+        const std::size_t tileRows = std::max<std::size_t>(1, TILE_POINTS / cols);
+
+        bool uploadPositions = !gpuWaves || !staticPositionsUploaded;
+        staticPositionsUploaded = gpuWaves;
+
+        // -------------------------------------------------------
+        // STEP 1: คำนวณตำแหน่งคลื่นทั้งหมดก่อน (ยังไม่วาด)
+        // kick off the wave solve in row tiles, the render thread keeps going until the upload
+        // instanced: the workers write straight into this frame's region of the position stream
+        // (not with the CPU LOD selection, it reads the positions back)
+        // -------------------------------------------------------
+        const std::size_t positionBytes = grid.getPointCount() * sizeof(glm::vec3);
+        const bool solveIntoStream = instancedMode && !cpuLods;
+        glm::vec3* framePos = currentFramePos.data();
+        if (uploadPositions && solveIntoStream)
+            framePos = (glm::vec3*)positionStream.beginWrite(positionBytes);
+
+        JobSystem::Fence solveFence;
+        if (!gpuWaves)
+        {
+            jobs.parallelFor(grid.getPointCount(), tileRows * cols, [&, time, framePos](std::size_t begin, std::size_t end)
+            {
+                Profiler::CpuScope scope(profiler, "wave solve");
+                waveSet.displace(grid.getBaseX() + begin, grid.getBaseY() + begin, grid.getBaseZ() + begin, framePos + begin, end - begin, time);
+            }, solveFence);
+        }
+        else if (uploadPositions)
+        {
+            // the undisplaced grid is drawn and the vertex shader applies the waves
+            grid.copyBasePositions(framePos);
+        }
+
+        // spheres shrink with the grid spacing so a dense grid stays readable
+        float sphereScale = SPHERE_RADIUS * std::min(1.0f, grid.getSpacing());
 
         // input
         // -----
-        processInput(window);
+        if (!headless)
+            processInput(window);
 
         // render
         // ------
@@ -176,97 +518,254 @@ int main()
         // activate shader
         ourShader.use();
 
-        // pass projection matrix to shader (note that in this case it could change every frame)
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        ourShader.setMat4("projection", projection);
+        // projection (it could change every frame), camera/view transformation and time in one block write
+        FrameUniforms frame;
+        frame.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        frame.view = camera.GetViewMatrix();
+        frame.time = time;
+        frameUBO.update(frame);
 
-        // camera/view transformation
-        glm::mat4 view = camera.GetViewMatrix();
-        ourShader.setMat4("view", view);
+        ourShader.setBool(gpuWavesLoc, gpuWaves);
 
-        // -------------------------------------------------------
-        // STEP 1: คำนวณตำแหน่งคลื่นทั้งหมดก่อน (ยังไม่วาด)
-        // -------------------------------------------------------
-        std::vector<glm::vec3> currentFramePos; // เก็บตำแหน่งของเฟรมนี้
-        currentFramePos.reserve(cubePositions.size());
-        for (unsigned int i = 0; i < cubePositions.size(); i++)
+        // completion fence: positions must be final before they are uploaded
         {
-            glm::vec3 basePos = cubePositions[i];
-            glm::vec3 offset(0.0f);
-            // Gerstner Wave Calculation
-            for (const auto& w : waves) {
-                float k = 2.0f * 3.14159f / w.wavelength;
-                float c = sqrt(9.8f / k) * w.speed;
-                glm::vec2 d = glm::normalize(w.direction);
-                float f = k * (glm::dot(d, glm::vec2(basePos.x, basePos.z)) - c * time);
-                float a = w.steepness / k;
-                offset.x += d.x * (a * cos(f));
-                offset.y += a * sin(f);
-                offset.z += d.y * (a * cos(f));
-            }
-            currentFramePos.push_back(basePos + offset);
+            Profiler::CpuScope scope(profiler, "solve wait");
+            jobs.wait(solveFence);
         }
 
         // -------------------------------------------------------
         // STEP 2: วาด Sphere (ใช้ตำแหน่งที่เพิ่งคำนวณ)
         // -------------------------------------------------------
-        glBindVertexArray(VAO);
+        // finish the upload of all positions; spheres and lines both read them
+        if (uploadPositions)
+        {
+            Profiler::CpuScope scope(profiler, "upload");
+            if (!solveIntoStream)
+                std::memcpy(positionStream.beginWrite(positionBytes), currentFramePos.data(), positionBytes);
+            positionOffset = positionStream.endWrite();
+
+            glBindBuffer(GL_ARRAY_BUFFER, positionStream.getId());
+            glBindVertexArray(sphereVAO);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)positionOffset);
+            if (tessMode)
+            {
+                glBindVertexArray(sphereTess.getVao());
+                glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)positionOffset);
+            }
+            glBindVertexArray(lineVAO);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)positionOffset);
+        }
 
-        for (const auto& pos : currentFramePos)
+        // LOD per sphere from its distance to the camera (the same test as the projected edge length,
+        // as one compare per level), then the instance offsets are regrouped by level
+        // gpuWaves: the undisplaced positions are used, the waves move a sphere by less than a switch band
+        if (cpuLods)
         {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, pos);
-            ourShader.setMat4("model", model);
-            glDrawElements(GL_TRIANGLES, sphere.getIndexCount(), GL_UNSIGNED_INT, 0);
+            Profiler::CpuScope scope(profiler, "lod select");
+            sphereLods.computeSwitchDistances(sphereScale, glm::radians(camera.Zoom), (float)SCR_HEIGHT, lodDistances);
+            for (float& d : lodDistances)
+                d *= d;
+
+            const glm::vec3 eye = camera.Position;
+            JobSystem::Fence lodFence;
+            jobs.parallelFor(grid.getPointCount(), tileRows * cols, [&, eye](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    glm::vec3 d = currentFramePos[i] - eye;
+                    float distance2 = glm::dot(d, d);
+                    unsigned char level = 0;
+                    while (distance2 < lodDistances[level])
+                        ++level;
+                    pointLods[i] = level;
+                }
+            }, lodFence);
+            jobs.wait(lodFence);
+
+            if (instancedMode)
+            {
+                std::fill(lodCounts.begin(), lodCounts.end(), 0);
+                for (std::size_t i = 0; i < pointLods.size(); ++i)
+                    ++lodCounts[pointLods[i]];
+                std::size_t start = 0;
+                for (std::size_t level = 0; level < lodCounts.size(); ++level)
+                {
+                    lodStarts[level] = start;
+                    start += lodCounts[level];
+                }
+
+                glm::vec3* lodPos = (glm::vec3*)lodStream.beginWrite(positionBytes);
+                lodNext = lodStarts;
+                for (std::size_t i = 0; i < pointLods.size(); ++i)
+                    lodPos[lodNext[pointLods[i]]++] = currentFramePos[i];
+                lodOffset = lodStream.endWrite();
+            }
         }
 
-        // -------------------------------------------------------
-        // STEP 3: วาดเส้นเชื่อม (Lines)
-        // -------------------------------------------------------
-        std::vector<glm::vec3> lineVertices;
-        int rows = 20; // ตาม loop x ของคุณ
-        int cols = 20; // ตาม loop z ของคุณ (y มีแค่ 1 ชั้น)
-        for (int x = 0; x < rows; ++x) {
-            for (int z = 0; z < cols; ++z) {
-                int index = x * cols + z; // สูตรแปลง 2D Grid เป็น 1D Array
-                if (index >= currentFramePos.size()) continue;
-                glm::vec3 p1 = currentFramePos[index];
-                // 1. เชื่อมไปทางขวา (ถ้ายังไม่ตกขอบ)
-                if (z < cols - 1) {
-                    glm::vec3 p2 = currentFramePos[index + 1];
-                    lineVertices.push_back(p1);
-                    lineVertices.push_back(p2);
+        glBindVertexArray(sphereVAO);
+        ourShader.setBool(perVertexWavesLoc, false);
+
+        sphereTriangles = 0;
+        {
+            Profiler::CpuScope cpuScope(profiler, "sphere draw");
+            Profiler::GpuScope gpuScope(profiler, "sphere draw");
+            if (tessMode)
+            {
+                // the level of each sphere is picked in the tessellation control shader
+                // collect the finished counts, oldest first; a full ring skips this frame's count
+                while (tessQueriesPending > 0)
+                {
+                    unsigned int query = tessQueries[(tessQueryNext - tessQueriesPending + TESS_QUERY_COUNT) % TESS_QUERY_COUNT];
+                    GLuint available = 0;
+                    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+                    if (!available)
+                        break;
+                    GLuint64 primitives = 0;
+                    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &primitives);
+                    tessTriangles = (std::size_t)primitives;
+                    --tessQueriesPending;
+                }
+                sphereTriangles = tessTriangles;
+                const bool countTriangles = tessQueriesPending < TESS_QUERY_COUNT;
+
+                sphereTess.setProjection(glm::radians(camera.Zoom), (float)SCR_HEIGHT);
+                sphereTess.use();
+                sphereTess.getShader().setBool(tessGpuWavesLoc, gpuWaves);
+                if (countTriangles)
+                    glBeginQuery(GL_PRIMITIVES_GENERATED, tessQueries[tessQueryNext]);
+                if (instancedMode)
+                {
+                    sphereTess.getShader().setMat4(tessModelLoc, glm::scale(glm::mat4(1.0f), glm::vec3(sphereScale)));
+                    sphereTess.draw((int)grid.getPointCount());
+                }
+                else
+                {
+                    for (std::size_t i = 0; i < currentFramePos.size(); ++i)
+                    {
+                        glm::mat4 model = glm::mat4(1.0f);
+                        model = glm::translate(model, currentFramePos[i]);
+                        model = glm::scale(model, glm::vec3(sphereScale));
+                        sphereTess.getShader().setMat4(tessModelLoc, model);
+                        sphereTess.draw();
+                    }
                 }
-                // 2. เชื่อมไปข้างล่าง (ถ้ายังไม่ตกขอบล่าง)
-                if (x < rows - 1) {
-                    glm::vec3 p3 = currentFramePos[index + cols];
-                    lineVertices.push_back(p1);
-                    lineVertices.push_back(p3);
+                if (countTriangles)
+                {
+                    glEndQuery(GL_PRIMITIVES_GENERATED);
+                    tessQueryNext = (tessQueryNext + 1) % TESS_QUERY_COUNT;
+                    ++tessQueriesPending;
+                }
+                ourShader.use();
+            }
+            else if (instancedMode && cpuLods)
+            {
+                // one instanced draw per level, location 3 re-pointed at the level's range of offsets
+                ourShader.setMat4(modelLoc, glm::scale(glm::mat4(1.0f), glm::vec3(sphereScale)));
+                glBindBuffer(GL_ARRAY_BUFFER, lodStream.getId());
+                for (int level = 0; level < sphereLods.getLevelCount(); ++level)
+                {
+                    if (lodCounts[level] == 0)
+                        continue;
+                    const IcosphereLodChain::Level& lod = sphereLods.getLevel(level);
+                    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+                                          (void*)(lodOffset + lodStarts[level] * sizeof(glm::vec3)));
+                    sphereLods.drawLevel(level, (int)lodCounts[level]);
+                    sphereTriangles += lodCounts[level] * lod.indexCount / 3;
+                }
+            }
+            else if (instancedMode)
+            {
+                // draw the whole grid in one call
+                const IcosphereLodChain::Level& lod = sphereLods.getLevel(finestLod);
+                ourShader.setMat4(modelLoc, glm::scale(glm::mat4(1.0f), glm::vec3(sphereScale)));
+                sphereLods.drawLevel(finestLod, (int)grid.getPointCount());
+                sphereTriangles = grid.getPointCount() * lod.indexCount / 3;
+            }
+            else
+            {
+                for (std::size_t i = 0; i < currentFramePos.size(); ++i)
+                {
+                    int level = cpuLods ? pointLods[i] : finestLod;
+                    glm::mat4 model = glm::mat4(1.0f);
+                    model = glm::translate(model, currentFramePos[i]);
+                    model = glm::scale(model, glm::vec3(sphereScale));
+                    ourShader.setMat4(modelLoc, model);
+                    sphereLods.drawLevel(level);
+                    sphereTriangles += sphereLods.getLevel(level).indexCount / 3;
                 }
             }
         }
+        if (instancedMode && cpuLods)
+            lodStream.endFrame();
 
-        // อัปเดตข้อมูลเส้นเข้า GPU
-        glBindVertexArray(lineVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-        glBufferData(GL_ARRAY_BUFFER, lineVertices.size() * sizeof(glm::vec3), lineVertices.data(), GL_DYNAMIC_DRAW);
-        
-        // ตั้งค่า Model Matrix ของเส้นให้เป็น Identity (เพราะพิกัดคำนวณมาเป็น World Space แล้ว)
-        ourShader.setMat4("model", glm::mat4(1.0f));
+        // -------------------------------------------------------
+        // STEP 3: วาดเส้นเชื่อม (Lines)
+        // -------------------------------------------------------
+        {
+            Profiler::CpuScope cpuScope(profiler, "line draw");
+            Profiler::GpuScope gpuScope(profiler, "line draw");
+            glBindVertexArray(lineVAO);
 
-        glDrawArrays(GL_LINES, 0, lineVertices.size());
+            // ตั้งค่า Model Matrix ของเส้นให้เป็น Identity (เพราะพิกัดคำนวณมาเป็น World Space แล้ว)
+            ourShader.setMat4(modelLoc, glm::mat4(1.0f));
+            ourShader.setBool(perVertexWavesLoc, true);   // each line vertex is its own grid point
+
+            glDrawElements(GL_LINES, (GLsizei)lineIndices.size(), GL_UNSIGNED_INT, 0);
+        }
+
+        // this frame's region may be reused once the GPU has passed these draws
+        if (uploadPositions)
+            positionStream.endFrame();
         
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
+        if (!headless)
+        {
+            Profiler::CpuScope scope(profiler, "swap");
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
+
+        // headless: wait for the GPU so each sample is the full frame cost
+        if (headless)
+        {
+            glFinish();
+            if (frameIndex >= WARMUP_FRAMES)
+                frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+        }
+        ++frameIndex;
+    }
+
+    // headless: frame time statistics
+    if (headless && !frameTimes.empty())
+    {
+        std::vector<double> sorted = frameTimes;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double t : sorted)
+            sum += t;
+        std::size_t last = sorted.size() - 1;
+        std::printf("frames %d (%d warm-up), grid %d x %d: avg %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                    (int)sorted.size(), WARMUP_FRAMES, grid.getWidth(), grid.getDepth(), sum / sorted.size(),
+                    sorted[last / 2], sorted[(std::size_t)(last * 0.99)], sorted[last]);
+        if (profiling)
+            std::printf("passes (ms/frame): %s\n", profiler.getSummary((std::uint32_t)std::min<std::size_t>(sorted.size(), 120)).c_str());
+        if (profiler.getGpuDropped() > 0)
+            std::printf("gpu timers dropped (not ready after 4 frames): %llu\n", (unsigned long long)profiler.getGpuDropped());
     }
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    releaseGlResources();
+
+    // dump the last frames of the profiler ring
+    profiler.releaseQueries();
+    if (profileDump)
+    {
+        if (profiler.writeCsv("profile.csv") && profiler.writeChromeTrace("profile.json"))
+            std::cout << "Profile written to profile.csv and profile.json (chrome://tracing)" << std::endl;
+    }
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -274,6 +773,57 @@ int main()
     return 0;
 }
 
+// upload cost of the grid positions per frame, for each write path and a few grid sizes
+// nothing is drawn, so this is the CPU side of the upload (copy, map/unmap, driver work)
+// ---------------------------------------------------------------------------------------
+void benchmarkStreamingUploads()
+{
+    const int FRAMES = 300;
+    const int sizes[] = { 20, 64, 256, 1024 };
+
+    std::cout << "Streaming upload benchmark, us/frame over " << FRAMES << " frames" << std::endl;
+    for (int n : sizes)
+    {
+        std::size_t bytes = (std::size_t)n * n * sizeof(glm::vec3);
+        std::vector<glm::vec3> data((std::size_t)n * n, glm::vec3(1.0f));
+        std::cout << "  " << n << " x " << n << " (" << bytes / 1024 << " KB)" << std::endl;
+
+        // reference: orphan + re-specify every frame (the old glBufferData path)
+        unsigned int vbo;
+        glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < FRAMES; ++i)
+            glBufferData(GL_ARRAY_BUFFER, bytes, data.data(), GL_STREAM_DRAW);
+        glFinish();
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "    glBufferData orphan: " << us / FRAMES << std::endl;
+        glDeleteBuffers(1, &vbo);
+
+        const StreamingBuffer::Mode modes[] = { StreamingBuffer::MODE_PERSISTENT, StreamingBuffer::MODE_MAP_RANGE, StreamingBuffer::MODE_SUBDATA };
+        for (StreamingBuffer::Mode mode : modes)
+        {
+            if (!StreamingBuffer::isModeSupported(mode))
+                continue;
+
+            StreamingBuffer stream(bytes, 3, mode);
+            glFinish();
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < FRAMES; ++i)
+            {
+                std::memcpy(stream.beginWrite(bytes), data.data(), bytes);
+                stream.endWrite();
+                stream.endFrame();
+            }
+            glFinish();
+            us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "    " << StreamingBuffer::getModeName(mode) << ": " << us / FRAMES << std::endl;
+            stream.release();
+        }
+    }
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow *window)
@@ -324,9 +874,112 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
     camera.ProcessMouseMovement(xoffset, yoffset);
 }
 
+// glfw: whenever a key is pressed, this callback is called (edge triggered, unlike processInput)
+// ----------------------------------------------------------------------------------------------
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action != GLFW_PRESS)
+        return;
+
+    // re-grid: halve / double the wave grid resolution
+    if (key == GLFW_KEY_LEFT_BRACKET)
+    {
+        gridWidth = std::max(2, gridWidth / 2);
+        gridDepth = std::max(2, gridDepth / 2);
+        gridChanged = true;
+    }
+    if (key == GLFW_KEY_RIGHT_BRACKET)
+    {
+        gridWidth = std::min(4096, gridWidth * 2);
+        gridDepth = std::min(4096, gridDepth * 2);
+        gridChanged = true;
+    }
+}
+
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
+
+// max abs difference between the grid points displaced by 7.4.camera.vs (gpuWaves,
+// captured with transform feedback, nothing rasterized) and by WaveSet on the CPU
+// at the given time; -1 if the capture program cannot be built
+// the Waves block must be bound already, the Frame block is overwritten
+// ---------------------------------------------------------------------------------
+float checkWaveParity(const WaveSet& waveSet, const WaveGrid& grid, UniformBuffer<FrameUniforms>& frameUBO, float time)
+{
+    // the scene program, relinked with worldPos as the transform feedback output
+    CachedShader program("7.4.camera.vs", "7.4.camera.fs");
+    if (!program.linked)
+        return -1.0f;
+    const char* varyings[] = { "worldPos" };
+    glTransformFeedbackVaryings(program.ID, 1, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program.ID);
+    int linkStatus = 0;
+    glGetProgramiv(program.ID, GL_LINK_STATUS, &linkStatus);
+    if (!linkStatus)
+    {
+        program.release();
+        return -1.0f;
+    }
+    program.bindBlock("Waves", WAVES_BINDING);
+    program.bindBlock("Frame", FRAME_BINDING);
+    program.use();
+    // relinking may move the uniforms, so no cached handles here
+    glm::mat4 identity(1.0f);
+    glUniformMatrix4fv(glGetUniformLocation(program.ID, "model"), 1, GL_FALSE, glm::value_ptr(identity));
+    glUniform1i(glGetUniformLocation(program.ID, "gpuWaves"), 1);
+    glUniform1i(glGetUniformLocation(program.ID, "perVertexWaves"), 1);
+
+    FrameUniforms frame;
+    frame.projection = identity;
+    frame.view = identity;
+    frame.time = time;
+    frameUBO.update(frame);
+
+    // one point per grid point, the undisplaced positions as aPos (aOffset stays (0, 0, 0))
+    std::size_t count = grid.getPointCount();
+    std::vector<glm::vec3> basePos(count);
+    grid.copyBasePositions(basePos.data());
+    unsigned int vao, vbo, captureBuffer;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &captureBuffer);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec3), basePos.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, captureBuffer);
+    glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, count * sizeof(glm::vec3), NULL, GL_STATIC_READ);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, captureBuffer);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, (GLsizei)count);
+    glEndTransformFeedback();
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    std::vector<glm::vec3> gpuPos(count);
+    glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, count * sizeof(glm::vec3), gpuPos.data());
+    std::vector<glm::vec3> cpuPos(count);
+    waveSet.displace(grid.getBaseX(), grid.getBaseY(), grid.getBaseZ(), cpuPos.data(), count, time);
+
+    float maxError = 0.0f;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        maxError = std::max(maxError, std::fabs(gpuPos[i].x - cpuPos[i].x));
+        maxError = std::max(maxError, std::fabs(gpuPos[i].y - cpuPos[i].y));
+        maxError = std::max(maxError, std::fabs(gpuPos[i].z - cpuPos[i].z));
+    }
+
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &captureBuffer);
+    program.release();
+    return maxError;
+}
@@ -0,0 +1,99 @@
+// Icosphere generation benchmark
+// build time of the smooth and flat icosphere for subdivision 1 to 64
+// (no window or GL context needed, only the vertex/index generation is timed;
+// glad.c is still linked in, Icosphere::draw() calls GL through it)
+// followed by the post-transform cache statistics before/after
+// Icosphere::optimizeVertexCache(), from a CPU-side FIFO cache simulation,
+// and the cold (generate + save) vs. warm (map + verify) MeshCache load time,
+// and the GPU memory of a CPU-built sphere vs. the tessellation backend
+#include "Icosphere.h"
+#include "IcosphereTessellator.h"
+#include "MeshCache.h"
+#include <chrono>
+#include <cstdio>
+
+// average ms to build one icosphere, repeated until ~200 ms have passed
+double timeBuild(int subdivision, bool smooth, unsigned int& vertexCount)
+{
+    int runs = 0;
+    double total = 0.0;
+    while (total < 200.0 || runs < 3)
+    {
+        auto start = std::chrono::steady_clock::now();
+        Icosphere sphere(1.0f, subdivision, smooth);
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        vertexCount = sphere.getVertexCount();
+        ++runs;
+    }
+    return total / runs;
+}
+
+int main()
+{
+    const int subdivisions[] = { 1, 2, 4, 8, 16, 32, 48, 64 };
+
+    std::printf("%5s %10s %12s %10s %12s\n", "sub", "smooth(ms)", "vertices", "flat(ms)", "vertices");
+    for (int subdivision : subdivisions)
+    {
+        unsigned int smoothCount = 0, flatCount = 0;
+        double smoothMs = timeBuild(subdivision, true, smoothCount);
+        double flatMs = timeBuild(subdivision, false, flatCount);
+        std::printf("%5d %10.3f %12u %10.3f %12u\n", subdivision, smoothMs, smoothCount, flatMs, flatCount);
+    }
+
+    // smooth spheres only, flat ones share no vertices (ACMR is always 3)
+    const int cacheSizes[] = { 16, 32 };
+    std::printf("\n%5s %6s %10s %10s %10s %10s %12s\n", "sub", "cache", "ACMR", "ACMR opt", "ATVR", "ATVR opt", "optimize(ms)");
+    for (int subdivision : subdivisions)
+    {
+        for (int cacheSize : cacheSizes)
+        {
+            Icosphere sphere(1.0f, subdivision, true);
+            float acmr = sphere.getAcmr(cacheSize);
+            float atvr = sphere.getAtvr(cacheSize);
+            auto start = std::chrono::steady_clock::now();
+            sphere.optimizeVertexCache(cacheSize);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::printf("%5d %6d %10.3f %10.3f %10.3f %10.3f %12.3f\n", subdivision, cacheSize,
+                        acmr, sphere.getAcmr(cacheSize), atvr, sphere.getAtvr(cacheSize), ms);
+        }
+    }
+
+    // cold start: generate, optimize and write the blob; warm start: map the blob and verify its checksum
+    // (the file is in the OS page cache by then, a first read from disk adds the I/O)
+    MeshCache cache("mesh_cache");
+    std::printf("\n%5s %10s %10s %12s\n", "sub", "cold(ms)", "warm(ms)", "blob(KB)");
+    for (int subdivision : subdivisions)
+    {
+        auto start = std::chrono::steady_clock::now();
+        Icosphere sphere(1.0f, subdivision, true);
+        sphere.optimizeVertexCache();
+        bool saved = cache.save(sphere, true);
+        double coldMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        bool hit = saved && cache.open(1.0f, subdivision, true, Icosphere::VERTEX_FORMAT_FLOAT, true);
+        double warmMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!hit)
+        {
+            std::printf("%5d cache write/read failed in %s\n", subdivision, cache.getDirectory().c_str());
+            continue;
+        }
+        unsigned int blobSize = cache.getInterleavedVertexSize() + (cache.getIndexCount() + cache.getLineIndexCount()) * 4;
+        std::printf("%5d %10.3f %10.3f %12u\n", subdivision, coldMs, warmMs, blobSize / 1024);
+        cache.close();
+    }
+
+    // VBO + EBO bytes of one smooth sphere; the tessellator uploads the icosahedron only, whatever the level
+    std::printf("\n%5s %12s %12s %12s\n", "sub", "float(KB)", "packed(KB)", "tess(B)");
+    for (int subdivision : subdivisions)
+    {
+        Icosphere sphere(1.0f, subdivision, true);
+        unsigned int floatSize = sphere.getInterleavedVertexSize() + sphere.getIndexSize();
+        sphere.setVertexFormat(Icosphere::VERTEX_FORMAT_PACKED);
+        unsigned int packedSize = sphere.getInterleavedVertexSize() + sphere.getIndexSize();
+        std::printf("%5d %12.1f %12.1f %12u\n", subdivision, floatSize / 1024.0, packedSize / 1024.0,
+                    IcosphereTessellator::getMemorySize());
+    }
+    return 0;
+}
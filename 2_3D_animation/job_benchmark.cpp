@@ -0,0 +1,102 @@
+// Job system scaling benchmark
+// one simulated frame of the wave grid on JobSystem with 0 to N-1 workers
+// (1 to N threads, the calling thread helps while it waits), no window or GL
+// context needed: the Gerstner solve in row tiles, then the line vertices
+// (each line's two displaced end points, gathered by rows as the per-frame
+// line build did before the static index buffer), for grids from 10k to ~1M
+// points. Prints ms per frame and the speedup over 1 thread.
+//
+// usage: job_benchmark [maxThreads]   (default: the hardware threads)
+#include "JobSystem.h"
+#include "WaveSet.h"
+#include "WaveGrid.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+const std::size_t TILE_POINTS = 4096;       // as camera_class.cpp
+
+// the wave set of camera_class.cpp
+const std::vector<WaveParams> WAVES = {
+    { { 1.0f,  0.1f },   0.35f,       20.0f,       0.80f },
+    { { 0.5f,  1.0f },   0.30f,       15.0f,       1.0f },
+    { {-0.3f,  0.8f },   0.25f,        8.0f,       1.20f },
+    { { 0.8f, -0.4f },   0.20f,        4.0f,       1.50f }
+};
+
+// average ms of one frame, repeated until ~300 ms have passed
+template<typename Frame>
+double timeFrames(Frame frame)
+{
+    int runs = 0;
+    double total = 0.0;
+    while (total < 300.0 || runs < 3)
+    {
+        auto start = std::chrono::steady_clock::now();
+        frame(runs * (1.0f / 60.0f));
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        ++runs;
+    }
+    return total / runs;
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int maxThreads = JobSystem::getDefaultWorkerCount() + 1;
+    if (argc > 1)
+        maxThreads = (unsigned int)std::max(1, std::atoi(argv[1]));
+
+    // 1, 2, 4, ... and the maximum
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    const int gridSizes[] = { 100, 256, 512, 1024 };        // 10k, 65k, 262k and 1M points
+    WaveSet waveSet(WAVES);
+
+    std::printf("%9s %8s %10s %8s\n", "points", "threads", "frame(ms)", "speedup");
+    for (int size : gridSizes)
+    {
+        WaveGrid grid(size, size, 1.0f, glm::vec3(-1.0f, -1.0f, -1.0f));
+        const std::size_t cols = (std::size_t)grid.getDepth();
+        const std::size_t tileRows = std::max<std::size_t>(1, TILE_POINTS / cols);
+        const std::size_t rowIndices = 4 * cols - 2;         // index pairs of one row, see WaveGrid::buildLineIndices()
+        std::vector<unsigned int> lineIndices;
+        grid.buildLineIndices(lineIndices);
+        std::vector<glm::vec3> framePos(grid.getPointCount());
+        std::vector<glm::vec3> lineVertices(lineIndices.size());
+
+        double oneThreadMs = 0.0;
+        for (unsigned int threads : threadCounts)
+        {
+            JobSystem jobs(threads - 1);
+            double ms = timeFrames([&](float time)
+            {
+                JobSystem::Fence solveFence;
+                jobs.parallelFor(grid.getPointCount(), tileRows * cols, [&, time](std::size_t begin, std::size_t end)
+                {
+                    waveSet.displace(grid.getBaseX() + begin, grid.getBaseY() + begin, grid.getBaseZ() + begin, framePos.data() + begin, end - begin, time);
+                }, solveFence);
+                jobs.wait(solveFence);
+
+                // by rows: row x owns lineIndices [x * rowIndices, (x + 1) * rowIndices), the last one fewer
+                JobSystem::Fence lineFence;
+                jobs.parallelFor((std::size_t)grid.getWidth(), tileRows, [&](std::size_t beginRow, std::size_t endRow)
+                {
+                    std::size_t end = std::min(endRow * rowIndices, lineIndices.size());
+                    for (std::size_t i = beginRow * rowIndices; i < end; ++i)
+                        lineVertices[i] = framePos[lineIndices[i]];
+                }, lineFence);
+                jobs.wait(lineFence);
+            });
+
+            if (threads == 1)
+                oneThreadMs = ms;
+            std::printf("%9zu %8u %10.3f %7.2fx\n", grid.getPointCount(), threads, ms, oneThreadMs / ms);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+// Gerstner wave benchmark
+// the per-point solver of the original render loop (k, c, normalize(direction)
+// and a recomputed for every wave at every point, through glm) against
+// WaveSet's baked constants table, at 400, 10k and 1M grid points
+// (no window or GL context needed); the max diff column is the float rounding
+// of the phase, which grows with the extent of the grid (1 spacing per point).
+// Then, per batch kernel (SoA path): the max position error against
+// KERNEL_SCALAR on a +-10 grid over a large time range, checked against
+// WAVE_SIMD_MAX_ERROR (exit code 1 past it), and the throughput in Mpoints/s
+#include "WaveSet.h"
+#include "WaveGrid.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// the wave set of camera_class.cpp
+const std::vector<WaveParams> WAVES = {
+    { { 1.0f,  0.1f },   0.35f,       20.0f,       0.80f },
+    { { 0.5f,  1.0f },   0.30f,       15.0f,       1.0f },
+    { {-0.3f,  0.8f },   0.25f,        8.0f,       1.20f },
+    { { 0.8f, -0.4f },   0.20f,        4.0f,       1.50f }
+};
+
+// the original STEP 1 loop, constants recomputed per point
+void solveOld(const std::vector<WaveParams>& waves, const std::vector<glm::vec3>& basePos, std::vector<glm::vec3>& outPos, float time)
+{
+    for (std::size_t i = 0; i < basePos.size(); ++i)
+    {
+        glm::vec3 pos = basePos[i];
+        glm::vec3 offset(0.0f);
+        for (const auto& w : waves) {
+            float k = 2.0f * 3.14159f / w.wavelength;
+            float c = sqrt(9.8f / k) * w.speed;
+            glm::vec2 d = glm::normalize(w.direction);
+            float f = k * (glm::dot(d, glm::vec2(pos.x, pos.z)) - c * time);
+            float a = w.steepness / k;
+            offset.x += d.x * (a * cos(f));
+            offset.y += a * sin(f);
+            offset.z += d.y * (a * cos(f));
+        }
+        outPos[i] = pos + offset;
+    }
+}
+
+// average ms of one solve, repeated until ~200 ms have passed
+template<typename Solve>
+double timeSolve(Solve solve)
+{
+    int runs = 0;
+    double total = 0.0;
+    while (total < 200.0 || runs < 3)
+    {
+        auto start = std::chrono::steady_clock::now();
+        solve(runs * (1.0f / 60.0f));
+        total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        ++runs;
+    }
+    return total / runs;
+}
+
+int main()
+{
+    const int gridSizes[] = { 20, 100, 1000 };             // 400, 10k and 1M points
+
+    WaveSet waveSet(WAVES);
+    waveSet.setKernel(WaveSet::KERNEL_SCALAR);
+
+    // old solver vs. the baked table, both per point through glm::vec3 (AoS)
+    std::printf("%9s %10s %10s %8s %12s\n", "points", "old(ms)", "baked(ms)", "speedup", "max diff");
+    for (int size : gridSizes)
+    {
+        WaveGrid grid(size, size, 1.0f, glm::vec3(-1.0f, -1.0f, -1.0f));
+        std::vector<glm::vec3> basePos(grid.getPointCount());
+        grid.copyBasePositions(basePos.data());
+        std::vector<glm::vec3> oldPos(basePos.size()), newPos(basePos.size());
+
+        double oldMs = timeSolve([&](float time) { solveOld(WAVES, basePos, oldPos, time); });
+        double newMs = timeSolve([&](float time) { waveSet.displace(basePos.data(), newPos.data(), basePos.size(), time); });
+
+        // same time in both: the table must reproduce the old formula
+        const float checkTime = 12.5f;
+        solveOld(WAVES, basePos, oldPos, checkTime);
+        waveSet.displace(basePos.data(), newPos.data(), basePos.size(), checkTime);
+        float maxDiff = 0.0f;
+        for (std::size_t i = 0; i < basePos.size(); ++i)
+        {
+            maxDiff = std::max(maxDiff, std::fabs(oldPos[i].x - newPos[i].x));
+            maxDiff = std::max(maxDiff, std::fabs(oldPos[i].y - newPos[i].y));
+            maxDiff = std::max(maxDiff, std::fabs(oldPos[i].z - newPos[i].z));
+        }
+        std::printf("%9zu %10.3f %10.3f %7.2fx %12.3g\n", basePos.size(), oldMs, newMs, oldMs / newMs, maxDiff);
+    }
+
+    // SIMD kernels against the scalar one: +-10 grid of 1M points, times up to ~1 day
+    const WaveSet::Kernel kernels[] = { WaveSet::KERNEL_SCALAR, WaveSet::KERNEL_SSE2, WaveSet::KERNEL_AVX2 };
+    const float checkTimes[] = { 0.0f, 0.37f, 12.5f, 123.4f, 1000.0f, 4321.0f, 12345.6f, 86400.0f };
+    WaveGrid checkGrid(1001, 1001, 0.02f, glm::vec3(-10.0f, 0.0f, -10.0f));
+    std::size_t checkCount = checkGrid.getPointCount();
+    std::vector<glm::vec3> scalarPos(checkCount), kernelPos(checkCount);
+
+    // throughput on the 1M point grid of the first table
+    WaveGrid grid(1000, 1000, 1.0f, glm::vec3(-1.0f, -1.0f, -1.0f));
+    std::vector<glm::vec3> outPos(grid.getPointCount());
+
+    bool passed = true;
+    std::printf("\n%8s %12s %10s %10s\n", "kernel", "max error", "ms (1M)", "Mpoints/s");
+    for (WaveSet::Kernel kernel : kernels)
+    {
+        if (!WaveSet::isKernelSupported(kernel))
+        {
+            std::printf("%8s not supported on this CPU\n", WaveSet::getKernelName(kernel));
+            continue;
+        }
+
+        float maxError = 0.0f;
+        for (float time : checkTimes)
+        {
+            waveSet.setKernel(WaveSet::KERNEL_SCALAR);
+            waveSet.displace(checkGrid.getBaseX(), checkGrid.getBaseY(), checkGrid.getBaseZ(), scalarPos.data(), checkCount, time);
+            waveSet.setKernel(kernel);
+            waveSet.displace(checkGrid.getBaseX(), checkGrid.getBaseY(), checkGrid.getBaseZ(), kernelPos.data(), checkCount, time);
+            for (std::size_t i = 0; i < checkCount; ++i)
+            {
+                maxError = std::max(maxError, std::fabs(scalarPos[i].x - kernelPos[i].x));
+                maxError = std::max(maxError, std::fabs(scalarPos[i].y - kernelPos[i].y));
+                maxError = std::max(maxError, std::fabs(scalarPos[i].z - kernelPos[i].z));
+            }
+        }
+
+        waveSet.setKernel(kernel);
+        double ms = timeSolve([&](float time) {
+            waveSet.displace(grid.getBaseX(), grid.getBaseY(), grid.getBaseZ(), outPos.data(), outPos.size(), time);
+        });
+        bool ok = maxError <= WAVE_SIMD_MAX_ERROR;
+        passed = passed && ok;
+        std::printf("%8s %12.3g %10.3f %10.1f%s\n", WaveSet::getKernelName(kernel), maxError, ms,
+                    outPos.size() / (ms * 1000.0), ok ? "" : "   FAIL: above WAVE_SIMD_MAX_ERROR");
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,291 @@
+#ifndef SHADER_CACHED_H
+#define SHADER_CACHED_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <unordered_map>
+
+// Shader program with the interface of learnopengl/shader_m.h, but every
+// active uniform location is queried once, right after linking, into a table.
+// set*(name) is then a hash lookup instead of a glGetUniformLocation() call,
+// and set*(location) with a handle from location() skips even that; resolve
+// the handles once outside the render loop.
+// Per-frame data shared by several programs goes into a std140 uniform block
+// (bindBlock() + UniformBuffer<T> below): one buffer write per frame.
+// A line #include "file" in a stage is replaced by that file (relative to the
+// including one), so blocks and functions used by several stages and
+// programs are written once.
+class CachedShader
+{
+public:
+    unsigned int ID;
+    bool linked;
+    // constructor reads and builds the shader; the tessellation stages need a GL 4.0 context
+    // ------------------------------------------------------------------------
+    CachedShader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
+                 const char* tessControlPath = nullptr, const char* tessEvaluationPath = nullptr)
+        : ID(0), linked(false)
+    {
+        struct Stage { const char* path; GLenum type; const char* name; };
+        Stage stages[5] = {
+            { vertexPath, GL_VERTEX_SHADER, "VERTEX" },
+            { fragmentPath, GL_FRAGMENT_SHADER, "FRAGMENT" },
+            { geometryPath, GL_GEOMETRY_SHADER, "GEOMETRY" },
+#ifdef GL_VERSION_4_0
+            { tessControlPath, GL_TESS_CONTROL_SHADER, "TESS_CONTROL" },
+            { tessEvaluationPath, GL_TESS_EVALUATION_SHADER, "TESS_EVALUATION" }
+#else
+            { nullptr, 0, "TESS_CONTROL" },
+            { nullptr, 0, "TESS_EVALUATION" }
+#endif
+        };
+        if ((tessControlPath || tessEvaluationPath) && stages[3].type == 0)
+        {
+            std::cout << "ERROR::SHADER::TESSELLATION_NOT_SUPPORTED" << std::endl;
+            return;
+        }
+
+        // 1. compile the given stages
+        // ---------------------------
+        unsigned int shaders[5] = { 0, 0, 0, 0, 0 };
+        bool compiled = true;
+        for (int i = 0; i < 5; ++i)
+        {
+            if (!stages[i].path)
+                continue;
+            shaders[i] = compileStage(stages[i].path, stages[i].type, stages[i].name);
+            compiled = compiled && shaders[i] != 0;
+        }
+        // 2. link
+        // -------
+        if (compiled)
+        {
+            ID = glCreateProgram();
+            for (int i = 0; i < 5; ++i)
+            {
+                if (shaders[i])
+                    glAttachShader(ID, shaders[i]);
+            }
+            glLinkProgram(ID);
+            linked = checkCompileErrors(ID, "PROGRAM");
+        }
+        // delete the shaders as they're linked into our program now and no longer necessary
+        for (int i = 0; i < 5; ++i)
+        {
+            if (shaders[i])
+                glDeleteShader(shaders[i]);
+        }
+        // 3. location table of the active uniforms (arrays as "name" and "name[0]")
+        // ---------------------------------------------------------------------------
+        if (linked)
+            buildLocationTable();
+    }
+    // activate the shader
+    // ------------------------------------------------------------------------
+    void use() const
+    {
+        glUseProgram(ID);
+    }
+    void release()
+    {
+        if (ID)
+            glDeleteProgram(ID);
+        ID = 0;
+        linked = false;
+        locations.clear();
+    }
+    // location of an active uniform, -1 if the program has none (glUniform*() ignores -1)
+    // ------------------------------------------------------------------------
+    int location(const std::string& name) const
+    {
+        std::unordered_map<std::string, int>::const_iterator it = locations.find(name);
+        return it == locations.end() ? -1 : it->second;
+    }
+    // bind a uniform block of this program to a UniformBuffer binding point
+    // ------------------------------------------------------------------------
+    void bindBlock(const std::string& name, unsigned int binding) const
+    {
+        unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, index, binding);
+    }
+    // utility uniform functions by handle
+    // ------------------------------------------------------------------------
+    void setBool(int location, bool value) const { glUniform1i(location, (int)value); }
+    void setInt(int location, int value) const { glUniform1i(location, value); }
+    void setFloat(int location, float value) const { glUniform1f(location, value); }
+    void setVec2(int location, const glm::vec2& value) const { glUniform2fv(location, 1, &value[0]); }
+    void setVec3(int location, const glm::vec3& value) const { glUniform3fv(location, 1, &value[0]); }
+    void setVec4(int location, const glm::vec4& value) const { glUniform4fv(location, 1, &value[0]); }
+    void setMat4(int location, const glm::mat4& mat) const { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat)); }
+    // utility uniform functions by name (table lookup)
+    // ------------------------------------------------------------------------
+    void setBool(const std::string& name, bool value) const { setBool(location(name), value); }
+    void setInt(const std::string& name, int value) const { setInt(location(name), value); }
+    void setFloat(const std::string& name, float value) const { setFloat(location(name), value); }
+    void setVec2(const std::string& name, const glm::vec2& value) const { setVec2(location(name), value); }
+    void setVec3(const std::string& name, const glm::vec3& value) const { setVec3(location(name), value); }
+    void setVec4(const std::string& name, const glm::vec4& value) const { setVec4(location(name), value); }
+    void setMat4(const std::string& name, const glm::mat4& mat) const { setMat4(location(name), mat); }
+
+private:
+    std::unordered_map<std::string, int> locations;
+
+    // read one source file with its #include lines expanded, false on failure
+    // ------------------------------------------------------------------------
+    static bool readSource(const std::string& path, std::string& code, int depth = 0)
+    {
+        std::string text;
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            file.open(path.c_str());
+            std::stringstream stream;
+            stream << file.rdbuf();
+            file.close();
+            text = stream.str();
+        }
+        catch(std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << " " << e.what() << std::endl;
+            return false;
+        }
+
+        std::string::size_type slash = path.find_last_of("/\\");
+        std::string directory = slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+        std::istringstream lines(text);
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(lines, line))
+        {
+            ++lineNumber;
+            std::string::size_type begin = line.find_first_not_of(" \t");
+            if (begin == std::string::npos || line.compare(begin, 8, "#include") != 0)
+            {
+                code += line;
+                code += '\n';
+                continue;
+            }
+            std::string::size_type open = line.find('"', begin);
+            std::string::size_type close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos || depth >= 8)
+            {
+                std::cout << "ERROR::SHADER::BAD_INCLUDE: " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            if (!readSource(directory + line.substr(open + 1, close - open - 1), code, depth + 1))
+                return false;
+            code += "#line " + std::to_string(lineNumber + 1) + "\n";     // compile errors keep the stage's line numbers
+        }
+        return true;
+    }
+    // read and compile one stage, 0 on failure
+    // ------------------------------------------------------------------------
+    static unsigned int compileStage(const char* path, GLenum type, const char* name)
+    {
+        std::string code;
+        if (!readSource(path, code))
+            return 0;
+        const char* source = code.c_str();
+        unsigned int shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+        if (!checkCompileErrors(shader, name))
+        {
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+    // utility function for checking shader compilation/linking errors.
+    // ------------------------------------------------------------------------
+    static bool checkCompileErrors(GLuint shader, const std::string& type)
+    {
+        GLint success;
+        GLchar infoLog[1024];
+        if (type != "PROGRAM")
+        {
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if (!success)
+            {
+                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+        else
+        {
+            glGetProgramiv(shader, GL_LINK_STATUS, &success);
+            if (!success)
+            {
+                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+        return success != 0;
+    }
+    // query every active uniform once; block members have no location and are skipped
+    // ------------------------------------------------------------------------
+    void buildLocationTable()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string name(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+            std::string uniform(name.c_str(), length);
+            int location = glGetUniformLocation(ID, uniform.c_str());
+            if (location < 0)
+                continue;
+            locations[uniform] = location;
+            std::string::size_type bracket = uniform.rfind("[0]");
+            if (bracket != std::string::npos && bracket + 3 == uniform.size())
+                locations[uniform.substr(0, bracket)] = location;
+        }
+    }
+};
+
+// std140 uniform buffer holding one T, bound to a fixed binding point;
+// T must follow the std140 rules (vec3/vec4/mat4 on 16 bytes, pad the tail).
+// update() rewrites the whole block with a single glBufferSubData().
+template<typename T>
+class UniformBuffer
+{
+public:
+    unsigned int ID;
+    unsigned int binding;
+
+    explicit UniformBuffer(unsigned int binding) : ID(0), binding(binding)
+    {
+        glGenBuffers(1, &ID);
+        glBindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), NULL, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+    }
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    void update(const T& data) const
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+    }
+    void release()
+    {
+        if (ID)
+            glDeleteBuffers(1, &ID);
+        ID = 0;
+    }
+};
+#endif
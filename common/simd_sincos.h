@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////////
+// simd_sincos.h
+// =============
+// 4-wide (SSE2) and 8-wide (AVX2 + FMA) single precision sincos for the
+// batched SoA kernels, Cephes polynomials after reduction to [-pi/4, pi/4]
+// (a few ulp on |x| < 8192; wrap large arguments first). Header only.
+//
+// SIMD_X86 is defined when the x86 paths are compiled in. The AVX2 functions
+// carry their own target attribute, so the file builds without -mavx2;
+// call them only when simdHasAvx2Fma() is true. simdSelectKernel() picks the
+// scalar, SSE2 or AVX2 path of a batched kernel at runtime.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMMON_SIMD_SINCOS_H
+#define COMMON_SIMD_SINCOS_H
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SIMD_TARGET_AVX2                    // MSVC emits AVX2 intrinsics without a flag
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace simd
+{
+    // Cephes single precision sincos: x = j * (pi/4) + r, |r| <= pi/4
+    const float FOUR_OVER_PI = 1.27323954473516f;
+    const float DP1 = -0.78515625f;                 // -pi/4 split in 3 parts
+    const float DP2 = -2.4187564849853515625e-4f;
+    const float DP3 = -3.77489497744594108e-8f;
+    const float SIN_P0 = -1.9515295891e-4f;
+    const float SIN_P1 = 8.3321608736e-3f;
+    const float SIN_P2 = -1.6666654611e-1f;
+    const float COS_P0 = 2.443315711809948e-5f;
+    const float COS_P1 = -1.388731625493765e-3f;
+    const float COS_P2 = 4.166664568298827e-2f;
+}
+
+#ifdef SIMD_X86
+///////////////////////////////////////////////////////////////////////////////
+// AVX2 + FMA on this CPU, and YMM state saved by the OS
+///////////////////////////////////////////////////////////////////////////////
+inline bool simdHasAvx2Fma()
+{
+    static const bool avx2 = []()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6)  // OS must save YMM state
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }();
+    return avx2;
+}
+#endif
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// runtime kernel selection shared by the batched SoA classes; their Kernel
+// enums use the same values
+///////////////////////////////////////////////////////////////////////////////
+enum SimdKernel { SIMD_KERNEL_AUTO, SIMD_KERNEL_SCALAR, SIMD_KERNEL_SSE2, SIMD_KERNEL_AVX2 };
+
+// check if this CPU (and OS) can run the kernel
+inline bool simdIsKernelSupported(SimdKernel kernel)
+{
+    switch (kernel)
+    {
+    case SIMD_KERNEL_SCALAR:
+        return true;
+#ifdef SIMD_X86
+    case SIMD_KERNEL_SSE2:
+        return true;                        // baseline on every x86 we build for
+    case SIMD_KERNEL_AVX2:
+        return simdHasAvx2Fma();
+#endif
+    default:
+        return false;
+    }
+}
+
+// AUTO picks the best supported kernel; unsupported kernels fall back to the next best one
+inline SimdKernel simdSelectKernel(SimdKernel kernel)
+{
+    if (kernel == SIMD_KERNEL_AUTO || !simdIsKernelSupported(kernel))
+    {
+        if (simdIsKernelSupported(SIMD_KERNEL_AVX2) && kernel != SIMD_KERNEL_SSE2)
+            kernel = SIMD_KERNEL_AVX2;
+        else if (simdIsKernelSupported(SIMD_KERNEL_SSE2))
+            kernel = SIMD_KERNEL_SSE2;
+        else
+            kernel = SIMD_KERNEL_SCALAR;
+    }
+    return kernel;
+}
+
+// name of a kernel for logging
+inline const char* simdKernelName(SimdKernel kernel)
+{
+    switch (kernel)
+    {
+    case SIMD_KERNEL_SCALAR: return "scalar";
+    case SIMD_KERNEL_SSE2:   return "SSE2";
+    case SIMD_KERNEL_AVX2:   return "AVX2";
+    default:                 return "auto";
+    }
+}
+
+
+
+#ifdef SIMD_X86
+///////////////////////////////////////////////////////////////////////////////
+// 4-wide sincos (SSE2)
+///////////////////////////////////////////////////////////////////////////////
+inline void sincos4(__m128 x, __m128* s, __m128* c)
+{
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+    __m128 signSin = _mm_and_ps(x, signMask);
+    x = _mm_andnot_ps(signMask, x);                                     // |x|
+
+    // octant j (rounded up to even) and reduced argument
+    __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(simd::FOUR_OVER_PI)));
+    j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    __m128 y = _mm_cvtepi32_ps(j);
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(simd::DP1)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(simd::DP2)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(simd::DP3)));
+
+    // signs and polynomial selection from the octant
+    __m128 swapSignSin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29));
+    __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+    __m128 signCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+    signSin = _mm_xor_ps(signSin, swapSignSin);
+
+    // cos(r) and sin(r) on [-pi/4, pi/4]
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(simd::COS_P0), z), _mm_set1_ps(simd::COS_P1));
+    pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(simd::COS_P2));
+    pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+    pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+    __m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(simd::SIN_P0), z), _mm_set1_ps(simd::SIN_P1));
+    ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(simd::SIN_P2));
+    ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), x), x);
+
+    __m128 sinR = _mm_or_ps(_mm_and_ps(polyMask, ps), _mm_andnot_ps(polyMask, pc));
+    __m128 cosR = _mm_or_ps(_mm_and_ps(polyMask, pc), _mm_andnot_ps(polyMask, ps));
+    *s = _mm_xor_ps(sinR, signSin);
+    *c = _mm_xor_ps(cosR, signCos);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// 8-wide sincos (AVX2 + FMA), same algorithm as sincos4()
+///////////////////////////////////////////////////////////////////////////////
+SIMD_TARGET_AVX2
+inline void sincos8(__m256 x, __m256* s, __m256* c)
+{
+    const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32((int)0x80000000));
+    __m256 signSin = _mm256_and_ps(x, signMask);
+    x = _mm256_andnot_ps(signMask, x);
+
+    __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(simd::FOUR_OVER_PI)));
+    j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    __m256 y = _mm256_cvtepi32_ps(j);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(simd::DP1), x);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(simd::DP2), x);
+    x = _mm256_fmadd_ps(y, _mm256_set1_ps(simd::DP3), x);
+
+    __m256 swapSignSin = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29));
+    __m256 polyMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+    __m256 signCos = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+    signSin = _mm256_xor_ps(signSin, swapSignSin);
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 pc = _mm256_fmadd_ps(_mm256_set1_ps(simd::COS_P0), z, _mm256_set1_ps(simd::COS_P1));
+    pc = _mm256_fmadd_ps(pc, z, _mm256_set1_ps(simd::COS_P2));
+    pc = _mm256_mul_ps(_mm256_mul_ps(pc, z), z);
+    pc = _mm256_add_ps(_mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), pc), _mm256_set1_ps(1.0f));
+    __m256 ps = _mm256_fmadd_ps(_mm256_set1_ps(simd::SIN_P0), z, _mm256_set1_ps(simd::SIN_P1));
+    ps = _mm256_fmadd_ps(ps, z, _mm256_set1_ps(simd::SIN_P2));
+    ps = _mm256_fmadd_ps(_mm256_mul_ps(ps, z), x, x);
+
+    __m256 sinR = _mm256_blendv_ps(pc, ps, polyMask);
+    __m256 cosR = _mm256_blendv_ps(ps, pc, polyMask);
+    *s = _mm256_xor_ps(sinR, signSin);
+    *c = _mm256_xor_ps(cosR, signCos);
+}
+#endif
+
+#endif